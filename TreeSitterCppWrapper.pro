@@ -12,20 +12,67 @@ INCLUDEPATH = \
 
 # Source files
 SOURCES = \
+	src/CTSAsyncParseService.cpp \
+	src/CTSBatchParser.cpp \
+	src/CTSCancellationToken.cpp \
+	src/CTSContentHash.cpp \
+	src/CTSDocumentStore.cpp \
 	src/CTSNode.cpp \
+	src/CTSFlatTree.cpp \
+	src/CTSIncrementalQuery.cpp \
+	src/CTSInjectionEngine.cpp \
+	src/CTSInputSource.cpp \
 	src/CTSLanguage.cpp \
+	src/CTSMappedFile.cpp \
+	src/CTSMemory.cpp \
+	src/CTSMetrics.cpp \
 	src/CTSParser.cpp \
+	src/CTSParseCache.cpp \
+	src/CTSParseSession.cpp \
+	src/CTSParseTask.cpp \
 	src/CTSTree.cpp \
+	src/CTSTreeWalker.cpp \
 	src/CTSQuery.cpp \
+	src/CTSQueryCache.cpp \
 	src/CTSQueryCursor.cpp \
+	src/CTSQueryExecutor.cpp \
+	src/CTSQueryPredicates.cpp \
+	src/CTSQueryRange.cpp \
+	src/CTSQueryResults.cpp \
+	src/CTSQuerySet.cpp \
+	src/CTSThreadPool.cpp \
     tree-sitter/lib/src/lib.c
 
 
 INCLUDES = \
+    include/CTSAsyncParseService.h \
+    include/CTSBatchParser.h \
+    include/CTSCancellationToken.h \
+    include/CTSContentHash.h \
+    include/CTSDocumentStore.h \
     include/CTSNode.h \
+    include/CTSFlatTree.h \
+    include/CTSIncrementalQuery.h \
+    include/CTSInjectionEngine.h \
+    include/CTSInputSource.h \
     include/CTSLanguage.h \
+    include/CTSMappedFile.h \
+    include/CTSMemory.h \
+    include/CTSMetrics.h \
     include/CTSParser.h \
+    include/CTSParseCache.h \
+    include/CTSParseSession.h \
+    include/CTSParseTask.h \
     include/CTSTree.h \
+    include/CTSTreeWalker.h \
     include/CTSQuery.h \
-    include/CTSQueryCursor.h
+    include/CTSQueryCache.h \
+    include/CTSQueryCursor.h \
+    include/CTSQueryExecutor.h \
+    include/CTSQueryPredicates.h \
+    include/CTSQueryRange.h \
+    include/CTSQueryResults.h \
+    include/CTSQuerySet.h \
+    include/CTSSymbolTable.h \
+    include/CTSThreadPool.h
 
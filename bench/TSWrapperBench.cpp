@@ -0,0 +1,410 @@
+// Micro-benchmarks for the wrapper's hot paths, each measured next to the raw
+// tree-sitter C API doing the same work.
+//
+//     TSWrapperBench [--iterations N] [--corpus DIR] [--query FILE] [FILE...]
+//
+// Without file arguments, every file in the corpus directory except
+// queries.scm is parsed, and queries.scm is the query that gets executed. The
+// default corpus matches the default grammar (tree-sitter-json); pass your own
+// corpus when building against another grammar.
+
+#include "TSWrapperLib.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" const TSLanguage* TSWRAPPER_BENCH_LANGUAGE(void);
+
+namespace
+{
+struct Document
+{
+    std::string path;
+    std::string text;
+};
+
+struct Options
+{
+    int iterations = 20;
+    std::string corpus = TSWRAPPER_BENCH_CORPUS_DIR;
+    std::string query;
+    std::vector<std::string> files;
+};
+
+std::string ReadFile(const std::string& path)
+{
+    std::ifstream      in(path, std::ios::binary);
+    std::ostringstream text;
+
+    text << in.rdbuf();
+    return text.str();
+}
+
+// Position of the given byte in text: rows count the newlines before it and
+// the column is measured in bytes from the last of them, as tree-sitter does.
+TSPoint PointAt(const std::string& text, uint32_t byte)
+{
+    TSPoint retval = { 0, 0 };
+
+    for (uint32_t idx = 0; idx < byte; idx++)
+    {
+        if (text[idx] == '\n')
+        {
+            retval.row++;
+            retval.column = 0;
+        }
+        else
+        {
+            retval.column++;
+        }
+    }
+    return retval;
+}
+
+// Runs body the given number of times after one warm-up run and prints the
+// median and best time per run. bytes, when non-zero, adds a throughput column.
+void Measure(const char *name, int iterations, size_t bytes, const std::function<void()>& body)
+{
+    std::vector<double> samples;
+
+    body();
+
+    for (int idx = 0; idx < iterations; idx++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        body();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    const double median = samples[samples.size() / 2];
+
+    std::printf("%-36s %12.1f %12.1f", name, median, samples.front());
+
+    if (bytes)
+    {
+        std::printf(" %10.1f", static_cast<double>(bytes) / median);
+    }
+    std::printf("\n");
+}
+
+uint32_t CountWithChildAccess(CTSNode node)
+{
+    uint32_t       retval = 1;
+    const uint32_t count  = node.ChildCount();
+
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        retval += CountWithChildAccess(node.Child(idx));
+    }
+    return retval;
+}
+
+uint32_t CountWithRawCursor(TSNode root)
+{
+    TSTreeCursor cursor = ts_tree_cursor_new(root);
+    uint32_t     retval = 0;
+
+    for (;;)
+    {
+        retval++;
+
+        if (ts_tree_cursor_goto_first_child(&cursor))
+        {
+            continue;
+        }
+
+        while (!ts_tree_cursor_goto_next_sibling(&cursor))
+        {
+            if (!ts_tree_cursor_goto_parent(&cursor))
+            {
+                ts_tree_cursor_delete(&cursor);
+                return retval;
+            }
+        }
+    }
+}
+
+bool ParseArguments(int argc, char **argv, Options& options)
+{
+    for (int idx = 1; idx < argc; idx++)
+    {
+        const std::string arg = argv[idx];
+
+        if ((arg == "--iterations") && (idx + 1 < argc))
+        {
+            options.iterations = std::max(1, std::atoi(argv[++idx]));
+        }
+        else if ((arg == "--corpus") && (idx + 1 < argc))
+        {
+            options.corpus = argv[++idx];
+        }
+        else if ((arg == "--query") && (idx + 1 < argc))
+        {
+            options.query = argv[++idx];
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            std::fprintf(stderr, "usage: %s [--iterations N] [--corpus DIR] [--query FILE] [FILE...]\n", argv[0]);
+            return false;
+        }
+        else
+        {
+            options.files.push_back(arg);
+        }
+    }
+
+    if (options.files.empty())
+    {
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator(options.corpus, error))
+        {
+            if (!entry.is_regular_file())
+            {
+                continue;
+            }
+
+            if (entry.path().filename() == "queries.scm")
+            {
+                if (options.query.empty())
+                {
+                    options.query = entry.path().string();
+                }
+            }
+            else
+            {
+                options.files.push_back(entry.path().string());
+            }
+        }
+        std::sort(options.files.begin(), options.files.end());
+    }
+    return true;
+}
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+
+    if (!ParseArguments(argc, argv, options))
+    {
+        return 2;
+    }
+
+    std::vector<Document> documents;
+    size_t                total_bytes = 0;
+
+    for (const std::string& path : options.files)
+    {
+        documents.push_back({ path, ReadFile(path) });
+        total_bytes += documents.back().text.size();
+    }
+
+    if (documents.empty())
+    {
+        std::fprintf(stderr, "no input files in %s\n", options.corpus.c_str());
+        return 2;
+    }
+
+    const TSLanguage *language = TSWRAPPER_BENCH_LANGUAGE();
+    CTSParser         parser(language);
+
+    if (!parser.LanguageSetResult())
+    {
+        std::fprintf(stderr, "the grammar's ABI version is not supported by this tree-sitter\n");
+        return 2;
+    }
+
+    TSParser *raw_parser = ts_parser_new();
+
+    ts_parser_set_language(raw_parser, language);
+
+    std::printf("%zu files, %zu bytes, %d iterations\n\n", documents.size(), total_bytes, options.iterations);
+    std::printf("%-36s %12s %12s %10s\n", "benchmark", "median us", "best us", "MB/s");
+
+    // Full parse.
+    Measure("parse/wrapper", options.iterations, total_bytes, [&]
+            {
+                for (const Document& doc : documents)
+                {
+                    parser.ParseString(doc.text);
+                }
+            });
+
+    Measure("parse/raw", options.iterations, total_bytes, [&]
+            {
+                for (const Document& doc : documents)
+                {
+                    ts_tree_delete(ts_parser_parse_string(raw_parser, nullptr, doc.text.data(),
+                                                          static_cast<uint32_t>(doc.text.size())));
+                }
+            });
+
+    // Incremental reparse after inserting one space in the middle of each
+    // document, then removing it again.
+    std::vector<std::shared_ptr<CTSTree> > trees;
+    std::vector<std::string>               edited;
+    std::vector<TSPoint>                   points;
+
+    for (const Document& doc : documents)
+    {
+        trees.push_back(parser.ParseString(doc.text));
+        edited.push_back(doc.text);
+        edited.back().insert(doc.text.size() / 2, " ");
+        points.push_back(PointAt(doc.text, static_cast<uint32_t>(doc.text.size() / 2)));
+    }
+
+    Measure("reparse/wrapper", options.iterations, 0, [&]
+            {
+                for (size_t idx = 0; idx < documents.size(); idx++)
+                {
+                    const uint32_t    at      = static_cast<uint32_t>(documents[idx].text.size() / 2);
+                    const TSPoint     point   = points[idx];
+                    const TSInputEdit insert  = { at, at, at + 1, point, point, { point.row, point.column + 1 } };
+                    const TSInputEdit remove  = { at, at + 1, at, point, { point.row, point.column + 1 }, point };
+                    auto              changed = parser.ReparseString(trees[idx]->Copy(trees[idx].get()), { insert }, edited[idx]);
+
+                    parser.ReparseString(changed, { remove }, documents[idx].text);
+                }
+            });
+
+    Measure("reparse/raw", options.iterations, 0, [&]
+            {
+                for (size_t idx = 0; idx < documents.size(); idx++)
+                {
+                    const uint32_t    at     = static_cast<uint32_t>(documents[idx].text.size() / 2);
+                    const TSPoint     point  = points[idx];
+                    const TSInputEdit insert = { at, at, at + 1, point, point, { point.row, point.column + 1 } };
+                    const TSInputEdit remove = { at, at + 1, at, point, { point.row, point.column + 1 }, point };
+                    TSTree           *copy   = ts_tree_copy(trees[idx]->RootNode().tree);
+
+                    ts_tree_edit(copy, &insert);
+                    TSTree *changed = ts_parser_parse_string(raw_parser, copy, edited[idx].data(),
+                                                             static_cast<uint32_t>(edited[idx].size()));
+
+                    ts_tree_edit(changed, &remove);
+                    TSTree *restored = ts_parser_parse_string(raw_parser, changed, documents[idx].text.data(),
+                                                              static_cast<uint32_t>(documents[idx].text.size()));
+
+                    ts_tree_delete(restored);
+                    ts_tree_delete(changed);
+                    ts_tree_delete(copy);
+                }
+            });
+
+    // Traversal of every node.
+    uint32_t checksum = 0;
+
+    Measure("traverse/node-child", options.iterations, 0, [&]
+            {
+                for (const auto& tree : trees)
+                {
+                    checksum += CountWithChildAccess(tree->RootNode());
+                }
+            });
+
+    Measure("traverse/walker", options.iterations, 0, [&]
+            {
+                for (const auto& tree : trees)
+                {
+                    for (CTSNode node : CTSTreeWalker::PreOrder(tree->RootNode()))
+                    {
+                        checksum += node.Symbol() != 0;
+                    }
+                }
+            });
+
+    Measure("traverse/raw-cursor", options.iterations, 0, [&]
+            {
+                for (const auto& tree : trees)
+                {
+                    checksum += CountWithRawCursor(tree->RootNode());
+                }
+            });
+
+    Measure("traverse/flat-tree-build", options.iterations, 0, [&]
+            {
+                for (const auto& tree : trees)
+                {
+                    checksum += CTSFlatTree(tree).NodeCount();
+                }
+            });
+
+    // Query execution.
+    if (!options.query.empty())
+    {
+        const std::string source = ReadFile(options.query);
+        const CTSQuery    query(language, source);
+
+        if (!query.IsValid())
+        {
+            std::fprintf(stderr, "%s: %s at offset %u\n", options.query.c_str(),
+                         query.DecodeLastErrorCode().c_str(), query.GetErrorOffset());
+            return 1;
+        }
+
+        CTSQueryCursor  cursor;
+        CTSQueryResults results;
+
+        Measure("query/compile", options.iterations, 0, [&]
+                {
+                    checksum += CTSQuery(language, source).PatternCount();
+                });
+
+        Measure("query/next-match", options.iterations, 0, [&]
+                {
+                    for (const auto& tree : trees)
+                    {
+                        cursor.Exec(query, tree->RootNode());
+
+                        while (cursor.NextMatch())
+                        {
+                            checksum += cursor.GetMatchResult().capture_count;
+                        }
+                    }
+                });
+
+        Measure("query/collect-all", options.iterations, 0, [&]
+                {
+                    for (const auto& tree : trees)
+                    {
+                        checksum += static_cast<uint32_t>(cursor.CollectAll(query, tree->RootNode(), results));
+                    }
+                });
+
+        Measure("query/raw", options.iterations, 0, [&]
+                {
+                    TSQueryCursor *raw_cursor = ts_query_cursor_new();
+                    TSQueryMatch   match;
+
+                    for (const auto& tree : trees)
+                    {
+                        ts_query_cursor_exec(raw_cursor, query.RawQuery(), tree->RootNode());
+
+                        while (ts_query_cursor_next_match(raw_cursor, &match))
+                        {
+                            checksum += match.capture_count;
+                        }
+                    }
+                    ts_query_cursor_delete(raw_cursor);
+                });
+    }
+
+    ts_parser_delete(raw_parser);
+
+    // Printing the checksum keeps the traversals from being optimized away.
+    std::printf("\nchecksum %u\n", checksum);
+    return 0;
+}
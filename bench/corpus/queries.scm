@@ -0,0 +1,8 @@
+; Highlight-style query for tree-sitter-json.
+(pair key: (string) @property)
+(pair value: (string) @string)
+(array (string) @string)
+(number) @number
+[(true) (false)] @constant.builtin
+(null) @constant.builtin
+(escape_sequence) @escape
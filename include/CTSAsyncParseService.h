@@ -0,0 +1,253 @@
+#pragma once
+
+#include "api.h"
+#include "CTSCancellationToken.h"
+#include "CTSMetrics.h"
+#include "CTSParser.h"
+#include "CTSTree.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One version of a document submitted to a `CTSAsyncParseService`.
+ */
+struct CTSAsyncParseRequest
+{
+    /**
+     * Identifies the document. Versions of one document are parsed in order,
+     * one at a time, each reusing the tree of the one before.
+     */
+    std::string document_id;
+
+    /**
+     * The version number, handed back in the result. The service does not
+     * interpret it.
+     */
+    uint64_t version = 0;
+
+    /**
+     * The full text of this version.
+     */
+    std::shared_ptr<const std::string> source;
+
+    /**
+     * The edits that turn the previously submitted version of the document
+     * into this one, in the form `CTSTree::Edit` expects. When empty, the text
+     * is treated as replaced wholesale and parsed from scratch.
+     */
+    std::vector<TSInputEdit> edits;
+};
+
+/**
+ * How a request submitted to a `CTSAsyncParseService` ended.
+ */
+enum class CTSAsyncParseStatus
+{
+    Completed,        // the tree is available
+    Superseded,       // a newer version of the document was submitted first
+    Cancelled,        // the service shut down or the document was closed
+    DeadlineExceeded, // the parse ran out of time; see CTSAsyncParseOptions
+    Failed            // the parser has no usable language
+};
+
+/**
+ * The outcome of one request.
+ */
+struct CTSAsyncParseResult
+{
+    std::string document_id;
+    uint64_t version = 0;
+    CTSAsyncParseStatus status = CTSAsyncParseStatus::Failed;
+
+    /**
+     * The new tree when status is Completed, otherwise nullptr. The service
+     * keeps sharing it as the base of the next reparse but never modifies it.
+     */
+    std::shared_ptr<CTSTree> tree;
+
+    /**
+     * Ranges whose syntax changed since the document's previous tree, see
+     * `CTSTree::GetChangedRanges`; the whole document after a full parse.
+     */
+    std::vector<TSRange> changed_ranges;
+};
+
+/**
+ * Settings of a `CTSAsyncParseService`.
+ */
+struct CTSAsyncParseOptions
+{
+    /**
+     * Number of worker threads, each with its own parser. Zero means one per
+     * hardware thread.
+     */
+    unsigned thread_count = 1;
+
+    /**
+     * Maximum number of requests waiting to be parsed. Requests for a document
+     * that already has one waiting replace it and do not count again.
+     */
+    size_t queue_capacity = 64;
+
+    /**
+     * Abandon a parse in progress as soon as a newer version of the same
+     * document arrives. Its edits are carried over to the newer version, which
+     * still reparses incrementally from the last completed tree.
+     */
+    bool cancel_superseded = true;
+
+    /**
+     * Time allowed for each parse; zero means unlimited.
+     */
+    std::chrono::microseconds parse_timeout{ 0 };
+
+    /**
+     * Sink installed on every worker's parser; see `CTSParser::SetMetricsSink`.
+     */
+    CTSMetricsSink* metrics = nullptr;
+};
+
+/**
+ * Parses documents on background threads.
+ *
+ * Callers submit successive versions of a document together with the edits
+ * between them and get a future (or a callback) for the resulting tree. The
+ * service keeps the last tree of every document and hands it to the parser
+ * for an incremental reparse automatically. While a version is still waiting
+ * in the queue, a newer version of the same document replaces it and the
+ * older request completes as Superseded, so bursts of typing cost one parse
+ * rather than one per keystroke. The queue is bounded: `Submit` blocks while
+ * it is full and `TrySubmit` turns the request away.
+ */
+class CTSAsyncParseService
+{
+public:
+    using Callback = std::function<void(const CTSAsyncParseResult& result)>;
+
+    CTSAsyncParseService() = delete;
+    CTSAsyncParseService(const CTSAsyncParseService&) = delete;
+    CTSAsyncParseService(const CTSAsyncParseService&&) = delete;
+    CTSAsyncParseService operator=(const CTSAsyncParseService&) = delete;
+    CTSAsyncParseService operator=(const CTSAsyncParseService&&) = delete;
+
+    /**
+     * Start the workers. Check `CTSAsyncParseService::LanguageSetResult()` to
+     * make sure the language was accepted.
+     */
+    CTSAsyncParseService(const TSLanguage* language, CTSAsyncParseOptions options = CTSAsyncParseOptions());
+
+    /**
+     * Cancel all outstanding requests and join the workers.
+     */
+    ~CTSAsyncParseService();
+
+    bool LanguageSetResult() const { return m_set_lang_result; }
+
+    unsigned ThreadCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+    /**
+     * Queue a request, waiting for room if the queue is full, and get a future
+     * for its result.
+     */
+    std::future<CTSAsyncParseResult> Submit(CTSAsyncParseRequest request);
+
+    /**
+     * Queue a request, waiting for room if the queue is full. callback is
+     * called with the result on a worker thread, or on the submitting thread
+     * if the request is superseded before it starts.
+     */
+    void Submit(CTSAsyncParseRequest request, Callback callback);
+
+    /**
+     * Queue a request if there is room. Returns false, without queueing the
+     * request, if the queue is full.
+     */
+    bool TrySubmit(CTSAsyncParseRequest request, std::future<CTSAsyncParseResult>* future);
+
+    /**
+     * Get the last completed tree of a document and its version, or nullptr.
+     */
+    std::shared_ptr<CTSTree> Tree(const std::string& document_id, uint64_t* version = nullptr) const;
+
+    /**
+     * Forget a document: a waiting request is cancelled, and the next request
+     * for the document is parsed from scratch.
+     */
+    void Close(const std::string& document_id);
+
+    /**
+     * Get the number of requests waiting to be parsed.
+     */
+    size_t QueueSize() const;
+
+    /**
+     * Wait until every request submitted so far has completed: its callback
+     * has returned or its future is ready.
+     */
+    void WaitIdle() const;
+
+private:
+    struct Job
+    {
+        CTSAsyncParseRequest request;
+        bool incremental = false;
+        std::promise<CTSAsyncParseResult> promise;
+        Callback callback;
+    };
+
+    struct Document
+    {
+        std::string id;
+        std::shared_ptr<CTSTree> tree;
+        uint64_t tree_version = 0;
+
+        // Edits between the text of tree and the text the next job starts
+        // from, left over from parses that did not complete.
+        // carry_valid is false when the text went through a wholesale
+        // replacement that never completed, so tree cannot be reused.
+        std::vector<TSInputEdit> carry_edits;
+        bool carry_valid = true;
+
+        std::unique_ptr<Job> pending;
+        bool in_flight = false;
+
+        // Set by Close while a parse is in flight; the generation tells that
+        // parse its result is stale even if the document is reopened.
+        bool closed = false;
+        uint64_t generation = 0;
+        CTSCancellationToken token;
+    };
+
+    bool Enqueue(std::unique_ptr<Job> job, bool wait);
+    void WorkerMain(unsigned worker);
+    void RunJob(Document* document, std::unique_ptr<Job> job, unsigned worker, std::unique_lock<std::mutex>& lock);
+    Document* NextDocument();
+    static void Resolve(std::unique_ptr<Job> job, CTSAsyncParseResult result);
+    void Resolved();
+    static CTSAsyncParseResult Outcome(const Job& job, CTSAsyncParseStatus status);
+
+    CTSAsyncParseOptions m_options;
+    std::vector<std::unique_ptr<CTSParser>> m_parsers;
+    std::vector<std::thread> m_threads;
+    bool m_set_lang_result = true;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;     // a job was queued, or stopping
+    std::condition_variable m_space;    // the queue shrank
+    mutable std::condition_variable m_idle;
+    std::unordered_map<std::string, std::unique_ptr<Document>> m_documents;
+    std::deque<Document*> m_queue;      // documents with a pending job, oldest first
+    unsigned m_running = 0;             // jobs taken off the queue and not yet resolved
+    bool m_stopping = false;
+};
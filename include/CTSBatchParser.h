@@ -0,0 +1,116 @@
+#pragma once
+
+#include "api.h"
+#include "CTSCancellationToken.h"
+#include "CTSParser.h"
+#include "CTSThreadPool.h"
+#include "CTSTree.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * One document to be parsed by a `CTSBatchParser`: either a file on disk or a
+ * buffer already held in memory.
+ */
+struct CTSBatchItem
+{
+    /**
+     * Create an item that parses the file at the given path. The file is
+     * memory-mapped while it is parsed, see `CTSParser::ParseFile`.
+     */
+    static CTSBatchItem File(std::string path) { return { std::move(path), {}, true }; }
+
+    /**
+     * Create an item that parses the given buffer in place. The buffer must
+     * stay alive until the batch has finished.
+     */
+    static CTSBatchItem Buffer(std::string_view buffer) { return { {}, buffer, false }; }
+
+    std::string path;
+    std::string_view buffer;
+    bool is_file = false;
+};
+
+class CTSBatchParser
+{
+public:
+    using Completion = std::function<void(size_t index, const std::shared_ptr<CTSTree>& tree)>;
+
+    CTSBatchParser() = delete;
+    CTSBatchParser(const CTSBatchParser&) = delete;
+    CTSBatchParser(const CTSBatchParser&&) = delete;
+    CTSBatchParser operator=(const CTSBatchParser&) = delete;
+    CTSBatchParser operator=(const CTSBatchParser&&) = delete;
+
+    /**
+     * Create a batch parser for the given language, backed by thread_count
+     * worker threads (zero means one per hardware thread). Each worker owns
+     * its own `CTSParser`, so parsers are never shared between threads.
+     *
+     * Check `CTSBatchParser::LanguageSetResult()` to make sure the language
+     * was accepted.
+     */
+    CTSBatchParser(const TSLanguage* language, unsigned thread_count = 0);
+
+    ~CTSBatchParser();
+
+    /**
+     * Returns true if every worker's parser accepted the language.
+     * See `CTSParser::LanguageSetResult()`.
+     */
+    bool LanguageSetResult() const { return m_set_lang_result; }
+
+    /**
+     * Get the number of worker threads, which is also the number of parsers.
+     */
+    unsigned ThreadCount() const { return m_pool.ThreadCount(); }
+
+    /**
+     * Parse every item and return the trees in the same order as the items.
+     *
+     * An entry is nullptr if its file could not be read or its parse failed.
+     */
+    std::vector<std::shared_ptr<CTSTree>> ParseAll(const std::vector<CTSBatchItem>& items);
+
+    /**
+     * Parse every item until the token is cancelled or its deadline passes.
+     *
+     * Parses in progress halt at their next check, and items not yet started
+     * are skipped; their entries are nullptr. Once the token fires, the call
+     * returns as soon as the workers have noticed.
+     */
+    std::vector<std::shared_ptr<CTSTree>> ParseAll(const std::vector<CTSBatchItem>& items,
+                                                   const CTSCancellationToken& token);
+
+    /**
+     * Parse every item and report each tree as soon as it is finished.
+     *
+     * on_complete is called once per item, in completion order, with the index
+     * of the item and its tree (nullptr on failure). Calls are serialized, so
+     * the callback does not need to be thread safe, but it should return quickly
+     * because it holds up the other workers. This method returns after the last
+     * callback has returned.
+     */
+    void ParseEach(const std::vector<CTSBatchItem>& items, const Completion& on_complete);
+
+    /**
+     * Parse every item until the token is cancelled or its deadline passes,
+     * reporting each tree as soon as it is finished. on_complete is still
+     * called for every item; items that were cut short or skipped get nullptr.
+     */
+    void ParseEach(const std::vector<CTSBatchItem>& items,
+                   const Completion& on_complete,
+                   const CTSCancellationToken& token);
+
+private:
+    std::shared_ptr<CTSTree> ParseItem(const CTSBatchItem& item, unsigned worker) const;
+    std::shared_ptr<CTSTree> ParseItem(const CTSBatchItem& item, unsigned worker, const CTSCancellationToken& token) const;
+
+    CTSThreadPool m_pool;
+    std::vector<std::unique_ptr<CTSParser>> m_parsers;
+    bool m_set_lang_result = true;
+};
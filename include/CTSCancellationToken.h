@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+
+/**
+ * A handle for cancelling parses from another thread, optionally combined
+ * with a deadline.
+ *
+ * Copies of a token share their state, so a token can be handed to a
+ * `CTSParseTask`, a `CTSBatchParser` or any number of workers, and cancelled
+ * through any copy. Cancellation cannot be undone; start a new token for the
+ * next piece of work.
+ */
+class CTSCancellationToken
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Create a token that is not cancelled and has no deadline.
+     */
+    CTSCancellationToken();
+
+    /**
+     * Create a token that counts as cancelled once the deadline has passed.
+     */
+    CTSCancellationToken(Clock::time_point deadline);
+
+    /**
+     * Create a token whose deadline lies the given duration from now.
+     */
+    static CTSCancellationToken After(std::chrono::microseconds duration) { return { Clock::now() + duration }; }
+
+    /**
+     * Request cancellation. Parses using the token halt at their next check.
+     */
+    void Cancel() const;
+
+    /**
+     * Returns true once `CTSCancellationToken::Cancel` has been called on
+     * any copy of the token.
+     */
+    bool IsCancelRequested() const;
+
+    /**
+     * Returns true if cancellation was requested or the deadline has passed.
+     */
+    bool IsCancelled() const;
+
+    /**
+     * Returns true if the token was created with a deadline.
+     */
+    bool HasDeadline() const { return m_state->deadline != Clock::time_point::max(); }
+
+    /**
+     * Get the deadline, or `Clock::time_point::max()` if there is none.
+     */
+    Clock::time_point Deadline() const { return m_state->deadline; }
+
+    /**
+     * Get the flag in the form `CTSParser::SetCancellationFlag` expects. It
+     * stays valid for as long as any copy of the token exists.
+     */
+    const size_t* Flag() const;
+
+private:
+    struct State
+    {
+        std::atomic<size_t> flag{ 0 };
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+
+    std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Hash a document's contents, for use as a cache key.
+ *
+ * This is the 64-bit xxHash algorithm (XXH64), which reads eight bytes at a
+ * time and hashes text far faster than it can be parsed. Unlike
+ * `CTSNameHash`, which is meant for short names, it is stable across
+ * processes and runs, so hashes can be stored on disk; they do assume a
+ * little-endian machine.
+ */
+uint64_t CTSContentHash(std::string_view content, uint64_t seed = 0);
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "CTSTree.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One published version of a document: its tree and, optionally, its text.
+ *
+ * A snapshot never changes once published, and stays alive for as long as
+ * anybody holds it, even after the store has moved on to newer versions.
+ */
+class CTSDocumentSnapshot
+{
+public:
+    CTSDocumentSnapshot() = delete;
+    CTSDocumentSnapshot(const CTSDocumentSnapshot&) = delete;
+    CTSDocumentSnapshot(const CTSDocumentSnapshot&&) = delete;
+    CTSDocumentSnapshot operator=(const CTSDocumentSnapshot&) = delete;
+    CTSDocumentSnapshot operator=(const CTSDocumentSnapshot&&) = delete;
+
+    const std::string& DocumentId() const { return m_document_id; }
+
+    uint64_t Version() const { return m_version; }
+
+    /**
+     * Get the text the tree was parsed from, or nullptr if none was published.
+     */
+    const std::shared_ptr<const std::string>& Source() const { return m_source; }
+
+    /**
+     * Get the snapshot's tree, shared by every reader of the snapshot. It must
+     * not be edited; use `CTSDocumentSnapshot::CopyTree` for a tree to edit or
+     * reparse from.
+     */
+    const std::shared_ptr<CTSTree>& Tree() const { return m_tree; }
+
+    /**
+     * Make a private copy of the tree. This is very fast, since the copy
+     * shares all nodes with the original (see `CTSTree::Copy`). tree-sitter
+     * requires a copy per thread for trees used on several threads at once.
+     */
+    std::shared_ptr<CTSTree> CopyTree() const { return m_tree ? m_tree->Copy(m_tree.get()) : nullptr; }
+
+private:
+    friend class CTSDocumentStore;
+
+    CTSDocumentSnapshot(std::string document_id,
+                        uint64_t version,
+                        std::shared_ptr<CTSTree> tree,
+                        std::shared_ptr<const std::string> source);
+
+    std::string m_document_id;
+    uint64_t m_version;
+    std::shared_ptr<CTSTree> m_tree;
+    std::shared_ptr<const std::string> m_source;
+};
+
+/**
+ * Publishes the latest tree of every document to any number of reader threads.
+ *
+ * A writer, typically the thread that applies edits and reparses, calls
+ * `CTSDocumentStore::Publish` with each new tree. The store takes its own
+ * copy of the tree, so the writer can go on editing and reparsing its tree
+ * while readers look at the published one. Readers call
+ * `CTSDocumentStore::Snapshot` and keep the result for as long as they need
+ * a consistent view.
+ *
+ * Readers never wait for writers: the current snapshot of each document, and
+ * the set of documents, are swapped with atomic shared_ptr operations, and
+ * the writer mutex only orders writers among themselves. A snapshot that is
+ * no longer current is reclaimed as soon as its last reader drops it.
+ */
+class CTSDocumentStore
+{
+public:
+    using SnapshotPtr = std::shared_ptr<const CTSDocumentSnapshot>;
+
+    CTSDocumentStore(const CTSDocumentStore&) = delete;
+    CTSDocumentStore(const CTSDocumentStore&&) = delete;
+    CTSDocumentStore operator=(const CTSDocumentStore&) = delete;
+    CTSDocumentStore operator=(const CTSDocumentStore&&) = delete;
+
+    CTSDocumentStore();
+    ~CTSDocumentStore() = default;
+
+    /**
+     * Make a copy of tree the current version of the document, adding the
+     * document if it is new. source, if given, is published along with it.
+     *
+     * Versions must increase: returns nullptr, and publishes nothing, if the
+     * document already has a snapshot with this or a later version, or if
+     * tree is nullptr. Otherwise returns the new snapshot.
+     */
+    SnapshotPtr Publish(const std::string& document_id,
+                        uint64_t version,
+                        const std::shared_ptr<CTSTree>& tree,
+                        std::shared_ptr<const std::string> source = nullptr);
+
+    /**
+     * Get the current snapshot of the document, or nullptr if it has none.
+     */
+    SnapshotPtr Snapshot(const std::string& document_id) const;
+
+    /**
+     * Get the current version of the document, or zero if it has none.
+     */
+    uint64_t Version(const std::string& document_id) const;
+
+    /**
+     * Remove the document. Readers still holding one of its snapshots keep it.
+     * Returns false if the document was not in the store.
+     */
+    bool Remove(const std::string& document_id);
+
+    /**
+     * Get the ids of all documents in the store.
+     */
+    std::vector<std::string> DocumentIds() const;
+
+    size_t DocumentCount() const;
+
+private:
+    // Each document has a slot whose snapshot is swapped on every publish.
+    // Slots live in a map that is itself copied and swapped whenever a
+    // document is added or removed, which is rare compared to publishing.
+    struct Slot
+    {
+        SnapshotPtr snapshot;
+    };
+
+    using Map = std::unordered_map<std::string, std::shared_ptr<Slot>>;
+
+    std::shared_ptr<Slot> FindSlot(const std::string& document_id) const;
+
+    std::shared_ptr<const Map> m_documents;
+    std::mutex m_write_mutex;
+};
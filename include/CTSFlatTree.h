@@ -0,0 +1,181 @@
+#pragma once
+
+#include "api.h"
+#include "CTSLanguage.h"
+#include "CTSNode.h"
+#include "CTSTree.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * A read-only snapshot of a syntax tree laid out as a struct of arrays.
+ *
+ * Building a CTSFlatTree walks the tree once with a tree cursor and records
+ * every node in pre-order, so node 0 is the root and the descendants of a node
+ * directly follow it. Each property lives in its own column (symbols, byte
+ * ranges, points, links, field ids, flags), and all columns share a single
+ * contiguous allocation. Analysis passes that look at one or two properties
+ * become linear scans over packed arrays instead of pointer chasing through
+ * the tree.
+ *
+ * Node links are indices into the columns; `CTSFlatTree::NoNode` marks a
+ * missing parent, child or sibling. `CTSFlatTree::Node` maps an index back to
+ * a regular `CTSNode` when the full node API is needed.
+ *
+ * A flat tree can be saved to a file and memory-mapped back later with
+ * `CTSFlatTree::Load`, which is far cheaper than parsing the source again. The
+ * file holds the columns exactly as they sit in memory, behind a header that
+ * records the language's `CTSLanguage::Fingerprint` and a hash of the source
+ * (see `CTSContentHash`). A loaded flat tree has no `CTSTree` behind it, so
+ * `CTSFlatTree::Node` is not available, but every column is.
+ */
+class CTSFlatTree
+{
+public:
+    static constexpr uint32_t NoNode = UINT32_MAX;
+
+    /**
+     * Version of the file layout written by `CTSFlatTree::Save`.
+     */
+    static constexpr uint32_t FormatVersion = 1;
+
+    /**
+     * Bits stored in the flags column.
+     */
+    enum Flag : uint8_t
+    {
+        FlagNamed    = 0x01, // see CTSNode::IsNamed
+        FlagMissing  = 0x02, // see CTSNode::IsMissing
+        FlagExtra    = 0x04, // see CTSNode::IsExtra
+        FlagHasError = 0x08, // see CTSNode::HasError
+        FlagIsError  = 0x10  // the node itself is an ERROR node
+    };
+
+    CTSFlatTree() = delete;
+    CTSFlatTree(const CTSFlatTree&) = delete;
+    CTSFlatTree(const CTSFlatTree&&) = delete;
+    CTSFlatTree operator=(const CTSFlatTree&) = delete;
+    CTSFlatTree operator=(const CTSFlatTree&&) = delete;
+
+    /**
+     * Flatten the given tree. The flat tree keeps a reference to the tree so
+     * that `CTSFlatTree::Node` can map indices back to nodes.
+     */
+    CTSFlatTree(const std::shared_ptr<CTSTree>& tree);
+
+    ~CTSFlatTree() = default;
+
+    /**
+     * Get the number of nodes, which is the length of every column.
+     */
+    uint32_t NodeCount() const { return m_count; }
+
+    /**
+     * Columns. Each pointer addresses NodeCount() consecutive entries.
+     */
+    const TSSymbol* Symbols() const { return m_symbols; }
+    const uint32_t* StartBytes() const { return m_start_bytes; }
+    const uint32_t* EndBytes() const { return m_end_bytes; }
+    const TSPoint* StartPoints() const { return m_start_points; }
+    const TSPoint* EndPoints() const { return m_end_points; }
+    const uint32_t* Parents() const { return m_parents; }
+    const uint32_t* FirstChildren() const { return m_first_children; }
+    const uint32_t* NextSiblings() const { return m_next_siblings; }
+    const uint32_t* ChildIndices() const { return m_child_indices; }
+    const TSFieldId* FieldIds() const { return m_field_ids; }
+    const uint8_t* Flags() const { return m_flags; }
+
+    /**
+     * Per-node accessors.
+     */
+    TSSymbol Symbol(uint32_t index) const { return m_symbols[index]; }
+    uint32_t StartByte(uint32_t index) const { return m_start_bytes[index]; }
+    uint32_t EndByte(uint32_t index) const { return m_end_bytes[index]; }
+    TSPoint StartPoint(uint32_t index) const { return m_start_points[index]; }
+    TSPoint EndPoint(uint32_t index) const { return m_end_points[index]; }
+    uint32_t Parent(uint32_t index) const { return m_parents[index]; }
+    uint32_t FirstChild(uint32_t index) const { return m_first_children[index]; }
+    uint32_t NextSibling(uint32_t index) const { return m_next_siblings[index]; }
+    TSFieldId FieldId(uint32_t index) const { return m_field_ids[index]; }
+    bool HasFlag(uint32_t index, Flag flag) const { return (m_flags[index] & flag) != 0; }
+    bool IsNamed(uint32_t index) const { return HasFlag(index, FlagNamed); }
+
+    /**
+     * Get the index one past the last descendant of the node, so that its
+     * subtree occupies [index, SubtreeEnd(index)) in every column.
+     */
+    uint32_t SubtreeEnd(uint32_t index) const;
+
+    /**
+     * Get the tree this snapshot was built from, or nullptr if it has none.
+     */
+    const std::shared_ptr<CTSTree>& Tree() const { return m_tree; }
+
+    /**
+     * Map a node index back to a `CTSNode` of the original tree.
+     *
+     * This retraces the path from the root, so it costs time proportional to
+     * the depth of the node. Returns a null node for an invalid index or when
+     * the snapshot has no tree.
+     */
+    CTSNode Node(uint32_t index) const;
+
+    /**
+     * Write the flat tree to a file, recording source_hash as the hash of the
+     * text it was parsed from. The file is written under a temporary name and
+     * renamed into place, so concurrent readers never see a partial file.
+     *
+     * Returns false if the file cannot be written, or if the snapshot has
+     * neither a tree nor a loaded header to take the language from.
+     */
+    bool Save(const std::string& path, uint64_t source_hash) const;
+
+    /**
+     * Map a file written by `CTSFlatTree::Save` back into memory. The columns
+     * point straight into the mapping, so loading costs a validation pass
+     * over the links rather than a parse.
+     *
+     * Returns nullptr if the file cannot be mapped, is not a flat tree file of
+     * this format version and byte order, was written for a language with a
+     * different fingerprint, records a different source hash, or is corrupt.
+     */
+    static std::shared_ptr<CTSFlatTree> Load(const std::string& path,
+                                             const CTSLanguage& language,
+                                             uint64_t source_hash);
+
+    /**
+     * Get the source hash recorded in the file a flat tree was loaded from,
+     * or zero for one built from a tree.
+     */
+    uint64_t SourceHash() const { return m_source_hash; }
+
+private:
+    struct FileHeader;
+
+    CTSFlatTree(std::shared_ptr<unsigned char> storage, uint32_t count);
+
+    static size_t StorageSize(uint32_t count);
+    void Bind(unsigned char* base, uint32_t count);
+    bool IsConsistent() const;
+
+    std::shared_ptr<CTSTree> m_tree;
+    std::shared_ptr<unsigned char> m_storage;
+    uint32_t m_count = 0;
+    uint32_t m_language_version = 0;
+    uint64_t m_language_fingerprint = 0;
+    uint64_t m_source_hash = 0;
+
+    uint32_t* m_start_bytes = nullptr;
+    uint32_t* m_end_bytes = nullptr;
+    TSPoint* m_start_points = nullptr;
+    TSPoint* m_end_points = nullptr;
+    uint32_t* m_parents = nullptr;
+    uint32_t* m_first_children = nullptr;
+    uint32_t* m_next_siblings = nullptr;
+    uint32_t* m_child_indices = nullptr;
+    TSSymbol* m_symbols = nullptr;
+    TSFieldId* m_field_ids = nullptr;
+    uint8_t* m_flags = nullptr;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "api.h"
+#include "CTSQuery.h"
+#include "CTSQueryCursor.h"
+#include "CTSQueryPredicates.h"
+#include "CTSTree.h"
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * A capture remembered by `CTSIncrementalQuery`. Captures are kept as ranges
+ * rather than nodes, since nodes do not survive a reparse.
+ */
+struct CTSIncrementalCapture
+{
+    uint32_t capture_id;
+    uint32_t start_byte;
+    uint32_t end_byte;
+    TSPoint start_point;
+    TSPoint end_point;
+};
+
+/**
+ * A match remembered by `CTSIncrementalQuery`. start_byte and end_byte span
+ * all of its captures.
+ */
+struct CTSIncrementalMatch
+{
+    uint32_t pattern_index;
+    uint32_t start_byte;
+    uint32_t end_byte;
+    std::vector<CTSIncrementalCapture> captures;
+};
+
+/**
+ * Keeps the matches of a query over a document up to date as the document is
+ * edited and reparsed, re-running the query only around what changed.
+ *
+ * After `CTSIncrementalQuery::Run` has evaluated the query over a whole tree,
+ * each `CTSIncrementalQuery::Update` takes the reparsed tree and the edits
+ * that produced it, and
+ * 1. shifts the remembered matches past each edit to their new positions,
+ * 2. collects the dirty ranges: the edited text plus the ranges reported by
+ *    `CTSTree::GetChangedRanges`,
+ * 3. widens each dirty range to the smallest named node enclosing it, then
+ *    to that node's ancestor context_depth levels up, and further up to the
+ *    nearest ancestor whose type one of the patterns starts at (see
+ *    `CTSQuery::RootSymbols`), so that the pattern enclosing the change is
+ *    evaluated as a whole,
+ * 4. drops the remembered matches that touch a widened range and re-runs the
+ *    query over those ranges only, with `CTSQueryCursor::SetByteRange`.
+ *
+ * A match found in several widened ranges is kept once, for the first of them,
+ * following the same rule as `CTSQueryExecutor::ExecRanges`. Only the nearest
+ * pattern root above a change is reached: a match rooted at a node further up,
+ * beyond context_depth, whose captures all stay clear of the widened range is
+ * not re-evaluated. Raise the depth for queries whose patterns nest inside
+ * one another across large constructs. Queries with wildcard or unrooted
+ * patterns only climb context_depth levels.
+ *
+ * Matches without captures are not remembered. The query (and predicates, if
+ * given) must outlive this object.
+ */
+class CTSIncrementalQuery
+{
+public:
+    CTSIncrementalQuery() = delete;
+    CTSIncrementalQuery(const CTSIncrementalQuery&) = delete;
+    CTSIncrementalQuery(const CTSIncrementalQuery&&) = delete;
+    CTSIncrementalQuery operator=(const CTSIncrementalQuery&) = delete;
+    CTSIncrementalQuery operator=(const CTSIncrementalQuery&&) = delete;
+
+    /**
+     * Create an incremental evaluator for the query. If predicates is given,
+     * matches that do not satisfy them are discarded, which requires the
+     * source text to be passed to `Run` and `Update`.
+     */
+    CTSIncrementalQuery(const CTSQuery& query, const CTSQueryPredicates* predicates = nullptr, uint32_t context_depth = 2);
+
+    ~CTSIncrementalQuery() = default;
+
+    /**
+     * Evaluate the query over the whole tree, replacing anything remembered.
+     */
+    void Run(const std::shared_ptr<CTSTree>& tree, std::string_view source = {});
+
+    /**
+     * Bring the matches up to date with new_tree, which was parsed from the
+     * previous tree after applying edits to it (see `CTSParser::Reparse`).
+     * The previous tree must have been edited with the same edits, so that
+     * its changed ranges against new_tree can be computed.
+     *
+     * Falls back to `CTSIncrementalQuery::Run` if no tree has been evaluated yet.
+     */
+    void Update(const std::shared_ptr<CTSTree>& new_tree,
+                const std::vector<TSInputEdit>& edits,
+                std::string_view source = {});
+
+    /**
+     * This is an overloaded method, for callers that already have the changed
+     * ranges at hand, for instance from `CTSParser::Reparse`.
+     */
+    void Update(const std::shared_ptr<CTSTree>& new_tree,
+                const std::vector<TSInputEdit>& edits,
+                const std::vector<TSRange>& changed_ranges,
+                std::string_view source = {});
+
+    /**
+     * Get the current matches, ordered by start byte.
+     */
+    const std::vector<CTSIncrementalMatch>& Matches() const { return m_matches; }
+
+    /**
+     * Get the widened ranges the last `Update` re-evaluated, ordered and
+     * disjoint. Outside of them, the matches did not change. After `Run`,
+     * this is the range of the whole tree.
+     */
+    const std::vector<TSRange>& UpdatedRanges() const { return m_updated; }
+
+    /**
+     * Get the tree the matches belong to.
+     */
+    const std::shared_ptr<CTSTree>& Tree() const { return m_tree; }
+
+private:
+    void Execute(const std::vector<TSRange>& ranges, size_t range_index,
+                 std::string_view source, std::vector<CTSIncrementalMatch>& out);
+    TSRange Widen(const TSRange& dirty) const;
+
+    const CTSQuery& m_query;
+    const CTSQueryPredicates* m_predicates;
+    uint32_t m_context_depth;
+
+    CTSQueryCursor m_cursor;
+    std::shared_ptr<CTSTree> m_tree;
+    std::vector<CTSIncrementalMatch> m_matches;
+    std::vector<TSRange> m_updated;
+};
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "api.h"
+#include "CTSParser.h"
+#include "CTSQuery.h"
+#include "CTSQueryCursor.h"
+#include "CTSQueryPredicates.h"
+#include "CTSTree.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * One language layer of a document parsed by `CTSInjectionEngine`.
+ *
+ * The host layer has depth 0 and no ranges, as it covers the whole document.
+ * An injected layer holds every region of its language found at its depth,
+ * parsed together as one tree whose included ranges are `ranges`.
+ */
+struct CTSInjectionLayer
+{
+    std::string language;
+    uint32_t depth = 0;
+    std::vector<TSRange> ranges;
+    std::shared_ptr<CTSTree> tree;
+
+    // True if the last `CTSInjectionEngine::Update` kept the edited tree of
+    // this layer without reparsing it, because no edit touched its ranges.
+    bool reused = false;
+};
+
+/**
+ * Parses documents that embed other languages, such as scripts in HTML, SQL
+ * in string literals or code blocks in Markdown, and keeps the resulting
+ * layers of trees up to date as the document is edited.
+ *
+ * Embedded regions are found with injection queries in the usual tree-sitter
+ * form: the region is captured as `@injection.content` and its language is
+ * either the text of an `@injection.language` capture or set with
+ * `(#set! injection.language "name")`. By default the text of the children of
+ * the content node is left out of the region; `(#set! injection.include-children)`
+ * keeps it. Text predicates of the queries are honoured.
+ *
+ * All regions of one language at one depth are combined into a single layer
+ * and parsed in one go with `CTSParser::SetIncludedRanges`, rather than with a
+ * parser round-trip per region. This is what `injection.combined` asks for in
+ * other tree-sitter hosts; here it is always the case. Each language has one
+ * parser, reused for every parse. Languages registered with an injection query
+ * of their own are searched for further injections, up to max_depth levels
+ * below the host.
+ *
+ * On `CTSInjectionEngine::Update`, every layer is edited and, when its
+ * regions moved or changed, reparsed incrementally from its previous tree.
+ * Layers whose regions no edit touched keep their edited tree as it is.
+ *
+ * Trees returned by this class are not edited afterwards, so they stay valid
+ * for as long as the caller holds them. A CTSInjectionEngine is not thread
+ * safe.
+ */
+class CTSInjectionEngine
+{
+public:
+    static constexpr uint32_t DefaultMaxDepth = 4;
+
+    CTSInjectionEngine() = delete;
+    CTSInjectionEngine(const CTSInjectionEngine&) = delete;
+    CTSInjectionEngine(const CTSInjectionEngine&&) = delete;
+    CTSInjectionEngine operator=(const CTSInjectionEngine&) = delete;
+    CTSInjectionEngine operator=(const CTSInjectionEngine&&) = delete;
+
+    /**
+     * Create an engine for documents written in the host language, which is
+     * registered under the given name with its injection query.
+     */
+    CTSInjectionEngine(const std::string& host,
+                       const TSLanguage*  language,
+                       std::string_view   injection_query,
+                       uint32_t           max_depth = DefaultMaxDepth);
+
+    ~CTSInjectionEngine() = default;
+
+    /**
+     * Register a language that may be injected under the given name. If
+     * injection_query is not empty, regions of this language are searched
+     * for further injections.
+     *
+     * Returns false if the name is taken, the language is null, or the
+     * injection query does not compile.
+     */
+    bool AddLanguage(const std::string& name, const TSLanguage* language, std::string_view injection_query = {});
+
+    /**
+     * Returns true if a language is registered under the given name.
+     */
+    bool HasLanguage(std::string_view name) const;
+
+    /**
+     * Returns false if the host language could not be registered, for
+     * instance because its injection query does not compile. Such an engine
+     * parses nothing.
+     */
+    bool IsValid() const { return m_host != nullptr; }
+
+    /**
+     * Parse a document from scratch, replacing all layers.
+     *
+     * Returns false if the host document could not be parsed, in which case
+     * there are no layers. Injected layers that fail to parse are left out.
+     */
+    bool Parse(std::string_view source);
+
+    /**
+     * Bring the layers up to date with source, which is the previous text
+     * after applying edits, in order.
+     *
+     * Falls back to `CTSInjectionEngine::Parse` if nothing has been parsed
+     * yet. Returns false if the host document could not be reparsed, in
+     * which case there are no layers.
+     */
+    bool Update(const std::vector<TSInputEdit>& edits, std::string_view source);
+
+    /**
+     * Get all layers: the host first, then the injected ones ordered by
+     * depth and language name.
+     */
+    const std::vector<CTSInjectionLayer>& Layers() const { return m_layers; }
+
+    /**
+     * Get the tree of the host document, or nullptr if nothing is parsed.
+     */
+    std::shared_ptr<CTSTree> HostTree() const;
+
+    /**
+     * Get the layer of the language at the given depth, or nullptr.
+     */
+    const CTSInjectionLayer* Layer(std::string_view language, uint32_t depth = 1) const;
+
+    /**
+     * Get the deepest layer whose text includes the byte at the given
+     * offset, or the host layer if no injected layer does. Returns nullptr
+     * if nothing is parsed.
+     */
+    const CTSInjectionLayer* LayerForByte(uint32_t byte) const;
+
+    /**
+     * Get the number of parses the last `Parse` or `Update` ran, including
+     * the host.
+     */
+    size_t ParseCount() const { return m_parse_count; }
+
+private:
+    struct Language
+    {
+        std::string name;
+        std::unique_ptr<CTSParser> parser;
+        std::unique_ptr<CTSQuery> query;
+        std::unique_ptr<CTSQueryPredicates> predicates;
+        uint32_t content_capture = UINT32_MAX;
+        uint32_t language_capture = UINT32_MAX;
+    };
+
+    using RangeMap = std::map<std::string, std::vector<TSRange>>;
+
+    bool Run(const std::vector<TSInputEdit>* edits, std::string_view source);
+    void FindInjections(const CTSInjectionLayer& layer, std::string_view source, RangeMap& found);
+    std::shared_ptr<CTSTree> ParseLayer(Language& language,
+                                        const std::vector<TSRange>& ranges,
+                                        const std::shared_ptr<CTSTree>& old_tree,
+                                        std::string_view source);
+    Language* Find(std::string_view name) const;
+
+    std::vector<std::unique_ptr<Language>> m_languages;
+    Language* m_host = nullptr;
+    std::vector<CTSInjectionLayer> m_layers;
+    CTSQueryCursor m_cursor;
+    uint32_t m_max_depth;
+    size_t m_parse_count = 0;
+};
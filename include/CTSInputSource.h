@@ -0,0 +1,187 @@
+#pragma once
+
+#include "api.h"
+
+#include <functional>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+/**
+ * Base class for objects that feed source text to a parser in chunks.
+ *
+ * A CTSInputSource produces the `TSInput` that `CTSParser::Parse` expects:
+ * tree-sitter calls back into the source whenever it needs the text at a given
+ * byte offset, and the source answers with a pointer into its own storage.
+ * The text is never gathered into one contiguous buffer, so documents kept in
+ * ropes, piece tables or streams can be parsed without flattening them first.
+ *
+ * The source also records which positions the parser asked for, which can be
+ * used to monitor parsing progress.
+ */
+class CTSInputSource
+{
+public:
+    CTSInputSource(const CTSInputSource&) = delete;
+    CTSInputSource(const CTSInputSource&&) = delete;
+    CTSInputSource operator=(const CTSInputSource&) = delete;
+    CTSInputSource operator=(const CTSInputSource&&) = delete;
+
+    virtual ~CTSInputSource() = default;
+
+    /**
+     * Get a `TSInput` that reads from this source.
+     *
+     * The returned structure refers to this object, which must outlive every
+     * parse that uses it.
+     */
+    TSInput GetTSInput() { return { this, &CTSInputSource::Read, m_encoding }; }
+
+    /**
+     * Get or set the encoding reported to the parser. Defaults to UTF-8.
+     */
+    TSInputEncoding Encoding() const { return m_encoding; }
+    void SetEncoding(TSInputEncoding encoding) { m_encoding = encoding; }
+
+    /**
+     * Get the byte offset and (row, column) position of the most recent read request.
+     */
+    uint32_t LastByte() const { return m_last_byte; }
+    TSPoint LastPoint() const { return m_last_point; }
+
+    /**
+     * Get the offset one past the furthest byte handed to the parser so far.
+     */
+    uint32_t BytesServed() const { return m_bytes_served; }
+
+    /**
+     * Get the number of times the parser has called back into this source.
+     */
+    uint64_t ReadCount() const { return m_read_count; }
+
+    /**
+     * Forget the positions recorded so far, e.g. before starting a new parse.
+     */
+    void ResetStatistics();
+
+protected:
+    CTSInputSource() = default;
+
+    /**
+     * Return a pointer to the text starting at `byte` and store the number of
+     * bytes available at that pointer in `length`. Store zero in `length` once
+     * `byte` is at or past the end of the document.
+     *
+     * The returned memory must stay valid until the next call.
+     */
+    virtual const char* ReadChunk(uint32_t byte, TSPoint point, uint32_t* length) = 0;
+
+private:
+    static const char* Read(void* payload, uint32_t byte, TSPoint point, uint32_t* bytes_read);
+
+    TSInputEncoding m_encoding = TSInputEncodingUTF8;
+    uint32_t m_last_byte = 0;
+    TSPoint m_last_point{};
+    uint32_t m_bytes_served = 0;
+    uint64_t m_read_count = 0;
+};
+
+/**
+ * An input source that forwards every read request to a callable, for example
+ * a lambda that looks up the chunk containing a byte offset in a rope.
+ *
+ * The callable receives the byte offset and position of the request and returns
+ * the text starting at that offset. An empty result marks the end of the document.
+ */
+class CTSFunctionInputSource : public CTSInputSource
+{
+public:
+    using ReadFunction = std::function<std::string_view(uint32_t byte, TSPoint point)>;
+
+    CTSFunctionInputSource(ReadFunction read) : m_read(std::move(read)) {}
+
+protected:
+    const char* ReadChunk(uint32_t byte, TSPoint point, uint32_t* length) override;
+
+private:
+    ReadFunction m_read;
+};
+
+/**
+ * An input source over an ordered list of chunks that together form the document,
+ * such as the pieces of a piece table or the leaves of a rope.
+ *
+ * Only views of the chunks are stored; the chunks themselves must outlive the
+ * source. Sequential reads are answered in constant time, random reads by a
+ * binary search over the chunk offsets.
+ */
+class CTSChunkListInputSource : public CTSInputSource
+{
+public:
+    CTSChunkListInputSource() = default;
+
+    /**
+     * Build a source from any sequence whose elements convert to std::string_view.
+     */
+    template <typename Chunks>
+    explicit CTSChunkListInputSource(const Chunks& chunks)
+    {
+        for (const auto& chunk : chunks)
+        {
+            Append(std::string_view(chunk));
+        }
+    }
+
+    /**
+     * Add a chunk to the end of the document. Empty chunks are ignored.
+     */
+    void Append(std::string_view chunk);
+
+    /**
+     * Remove all chunks.
+     */
+    void Clear();
+
+    /**
+     * Get the total number of bytes in all chunks.
+     */
+    uint32_t Length() const { return m_length; }
+
+protected:
+    const char* ReadChunk(uint32_t byte, TSPoint point, uint32_t* length) override;
+
+private:
+    std::vector<std::string_view> m_chunks;
+    std::vector<uint32_t> m_offsets;
+    uint32_t m_length = 0;
+    size_t m_cursor = 0;
+};
+
+/**
+ * An input source that reads the document from a std::istream in fixed-size blocks.
+ *
+ * When the stream is seekable, only one block is kept in memory and earlier
+ * offsets are re-read on demand. When it is not, everything read so far is kept
+ * so that the parser can still look back.
+ */
+class CTSStreamInputSource : public CTSInputSource
+{
+public:
+    static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+    CTSStreamInputSource(std::istream& stream, size_t block_size = DefaultBlockSize);
+
+protected:
+    const char* ReadChunk(uint32_t byte, TSPoint point, uint32_t* length) override;
+
+private:
+    bool Fill(uint32_t byte);
+
+    std::istream& m_stream;
+    std::streampos m_base;
+    std::vector<char> m_buffer;
+    size_t m_block_size;
+    uint32_t m_buffer_start = 0;
+    bool m_seekable;
+    bool m_at_end = false;
+};
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "api.h"
+#include "CTSSymbolTable.h"
+
+#include <initializer_list>
 #include <string>
+#include <string_view>
+#include <vector>
 
 
 struct CTSLanguage
@@ -37,11 +42,63 @@ public:
      */
     std::string SymbolName(TSSymbol symbol) const;
 
+    /**
+     * Get a node type string for the given numerical id without allocating.
+     *
+     * The names of all symbols are looked up once, when the CTSLanguage is
+     * constructed, so this is a plain table lookup. The view points into
+     * static storage owned by the language and never dangles.
+     */
+    std::string_view SymbolNameView(TSSymbol symbol) const;
+
     /**
      * Get the numerical id for the given node type string.
      */
     TSSymbol SymbolForName(const std::string &name, bool is_named) const;
 
+    /**
+     * Get the `CTSNameHash` of the given symbol's name from a precomputed table.
+     *
+     * Use this to dispatch on node kinds with an integer switch over
+     * compile-time hashes of the names of interest.
+     */
+    uint64_t SymbolHash(TSSymbol symbol) const;
+
+    /**
+     * Get every symbol whose node type string is `name`.
+     *
+     * A grammar can use the same name for a named and an anonymous node, or
+     * for several aliased symbols, so there may be more than one.
+     */
+    std::vector<TSSymbol> SymbolsForName(std::string_view name) const;
+
+    /**
+     * Resolve a list of node type strings to a set of symbols, once, so that
+     * later tests are `CTSSymbolSet::Contains` calls instead of string compares.
+     * Names that do not exist in the language are ignored.
+     */
+    CTSSymbolSet ResolveSymbols(std::initializer_list<std::string_view> names) const;
+
+    /**
+     * Build a jump table that maps each symbol named in `entries` to its value.
+     * Symbols not listed map to default_value.
+     */
+    template <typename T>
+    CTSSymbolMap<T> MakeSymbolMap(std::initializer_list<std::pair<std::string_view, T>> entries,
+                                  T default_value = T()) const
+    {
+        CTSSymbolMap<T> retval(default_value);
+
+        for (const auto& entry : entries)
+        {
+            for (const TSSymbol symbol : SymbolsForName(entry.first))
+            {
+                retval.Set(symbol, entry.second);
+            }
+        }
+        return retval;
+    }
+
     /**
      * Get the number of distinct field names in the language.
      */
@@ -52,11 +109,25 @@ public:
      */
     std::string FieldNameForId(TSFieldId id) const;
 
+    /**
+     * Get the field name string for the given numerical id without allocating.
+     *
+     * Returns an empty view for ids that do not name a field. See also
+     * `CTSLanguage::SymbolNameView`.
+     */
+    std::string_view FieldNameViewForId(TSFieldId id) const;
+
     /**
      * Get the numerical id for the given field name string.
      */
     TSFieldId FieldIdForName(const std::string &name) const;
 
+    /**
+     * Resolve a list of field names to field ids, in the same order.
+     * Names that do not exist in the language resolve to zero.
+     */
+    std::vector<TSFieldId> ResolveFields(std::initializer_list<std::string_view> names) const;
+
     /**
      * Check whether the given node type id belongs to named nodes, anonymous nodes,
      * or a hidden nodes.
@@ -75,8 +146,21 @@ public:
      */
     uint32_t Version() const { return ts_language_version(m_language); }
 
+    /**
+     * Get a hash of the language's ABI version, symbol names and types, and
+     * field names. Two languages with the same fingerprint number their node
+     * types the same way, so data recorded against one, such as a serialized
+     * `CTSFlatTree`, can be read back with the other.
+     */
+    uint64_t Fingerprint() const { return m_fingerprint; }
+
 
     const TSLanguage* GetTSLanguage() const { return m_language; }
 private:
     const TSLanguage* m_language;
+
+    std::vector<std::string_view> m_symbol_names;
+    std::vector<uint64_t> m_symbol_hashes;
+    std::vector<std::string_view> m_field_names;
+    uint64_t m_fingerprint = 0;
 };
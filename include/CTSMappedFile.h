@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class CTSMappedFile
+{
+public:
+    CTSMappedFile() = delete;
+    CTSMappedFile(const CTSMappedFile&) = delete;
+    CTSMappedFile(const CTSMappedFile&&) = delete;
+    CTSMappedFile operator=(const CTSMappedFile&) = delete;
+    CTSMappedFile operator=(const CTSMappedFile&&) = delete;
+
+    /**
+     * Map the given file read-only into memory.
+     *
+     * The contents are not copied; pages are loaded by the operating system
+     * as they are touched. Check `CTSMappedFile::IsValid()` to find out whether
+     * the file could be opened and mapped. An empty file is valid and has
+     * an empty `CTSMappedFile::View()`.
+     */
+    CTSMappedFile(const std::string& path);
+
+    /**
+     * Unmap the file, invalidating every pointer obtained from this object.
+     */
+    ~CTSMappedFile();
+
+    /**
+     * Returns true if the file was opened and mapped successfully.
+     */
+    bool IsValid() const { return m_valid; }
+
+    /**
+     * Get a pointer to the first byte of the mapped contents.
+     */
+    const char* Data() const { return m_data; }
+
+    /**
+     * Get the size of the mapped contents in bytes.
+     */
+    size_t Size() const { return m_size; }
+
+    /**
+     * Get the mapped contents as a string view.
+     */
+    std::string_view View() const { return { m_data, m_size }; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_valid = false;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Allocation counters for one wrapper object (a parser, tree or query).
+ *
+ * While `CTSMemory` is installed, every block tree-sitter allocates is charged
+ * to the account that is current on the allocating thread (see
+ * `CTSMemoryScope`), and credited back to the same account when it is freed,
+ * whichever thread frees it. Accounts are reference counted: the owning
+ * object holds one reference and every live block holds another, so an
+ * account outlives its owner for as long as memory charged to it is alive.
+ */
+class CTSMemoryAccount
+{
+public:
+    CTSMemoryAccount(const CTSMemoryAccount&) = delete;
+    CTSMemoryAccount(const CTSMemoryAccount&&) = delete;
+    CTSMemoryAccount operator=(const CTSMemoryAccount&) = delete;
+    CTSMemoryAccount operator=(const CTSMemoryAccount&&) = delete;
+
+    /**
+     * Create an account holding one reference for the caller, or return
+     * nullptr if `CTSMemory` is not installed.
+     */
+    static CTSMemoryAccount* Create();
+
+    void Retain() { m_refs.fetch_add(1, std::memory_order_relaxed); }
+    void Release();
+
+    /**
+     * Get the number of bytes currently allocated and charged to this account.
+     */
+    size_t Bytes() const { return static_cast<size_t>(m_bytes.load(std::memory_order_relaxed)); }
+
+    /**
+     * Get the number of blocks currently allocated and charged to this account.
+     */
+    size_t Allocations() const { return static_cast<size_t>(m_allocations.load(std::memory_order_relaxed)); }
+
+    /**
+     * Get the number of blocks ever charged to this account.
+     */
+    uint64_t TotalAllocations() const { return m_total_allocations.load(std::memory_order_relaxed); }
+
+private:
+    friend class CTSMemory;
+
+    CTSMemoryAccount() = default;
+
+    void Charge(size_t bytes);
+    void Credit(size_t bytes);
+
+    std::atomic<int64_t> m_refs{ 1 };
+    std::atomic<int64_t> m_bytes{ 0 };
+    std::atomic<int64_t> m_allocations{ 0 };
+    std::atomic<uint64_t> m_total_allocations{ 0 };
+};
+
+/**
+ * Makes an account current on this thread for the lifetime of the scope, so
+ * that tree-sitter allocations made in the meantime are charged to it. Scopes
+ * nest; the previous account is restored on destruction. A null account
+ * leaves allocations uncharged.
+ */
+class CTSMemoryScope
+{
+public:
+    CTSMemoryScope(const CTSMemoryScope&) = delete;
+    CTSMemoryScope(const CTSMemoryScope&&) = delete;
+    CTSMemoryScope operator=(const CTSMemoryScope&) = delete;
+    CTSMemoryScope operator=(const CTSMemoryScope&&) = delete;
+
+    CTSMemoryScope(CTSMemoryAccount* account);
+    ~CTSMemoryScope();
+
+private:
+    CTSMemoryAccount* m_previous;
+};
+
+/**
+ * A bump allocator for tree-sitter allocations.
+ *
+ * While an arena is current on a thread (see `CTSArenaScope`) and `CTSMemory`
+ * is installed, tree-sitter allocations made on that thread are carved out of
+ * large blocks owned by the arena. Freeing such an allocation is a no-op; the
+ * memory is returned in one go, block by block, when the arena is destroyed.
+ * This suits parses whose trees are all dropped together, and keeps their
+ * nodes off the shared heap.
+ *
+ * Trees and parsers that may hold arena memory keep the arena alive through a
+ * shared_ptr (see `CTSParser::CTSParser(const TSLanguage*, std::shared_ptr<CTSArena>)`),
+ * so an arena is never destroyed while a block carved out of it is in use.
+ *
+ * Arena and pooled blocks are not blocks `malloc` returned, so every buffer
+ * tree-sitter hands to the caller, such as the results of
+ * `ts_tree_get_changed_ranges` and `ts_node_string`, must be released with
+ * `ts_current_free` rather than `free`. The wrapper's own accessors already
+ * do so.
+ */
+class CTSArena
+{
+public:
+    static constexpr size_t DefaultBlockSize = 1 << 20;
+
+    CTSArena(const CTSArena&) = delete;
+    CTSArena(const CTSArena&&) = delete;
+    CTSArena operator=(const CTSArena&) = delete;
+    CTSArena operator=(const CTSArena&&) = delete;
+
+    /**
+     * Create an empty arena. Blocks of block_size bytes are reserved as needed;
+     * requests larger than a quarter of that get a block of their own.
+     */
+    CTSArena(size_t block_size = DefaultBlockSize);
+
+    /**
+     * Releases every block of the arena.
+     */
+    ~CTSArena();
+
+    /**
+     * Get the number of bytes reserved from the system for this arena.
+     */
+    size_t ReservedBytes() const { return m_reserved; }
+
+    /**
+     * Get the number of bytes handed out from this arena, including headers
+     * and padding, and including blocks tree-sitter has since freed.
+     */
+    size_t UsedBytes() const { return m_used; }
+
+    /**
+     * Get the number of blocks reserved from the system.
+     */
+    size_t BlockCount() const { return m_blocks.size(); }
+
+    /**
+     * Add every arena of from that is not already in into to into.
+     */
+    static void Merge(std::vector<std::shared_ptr<CTSArena>>& into,
+                      const std::vector<std::shared_ptr<CTSArena>>& from);
+
+private:
+    friend class CTSMemory;
+
+    void* Allocate(size_t bytes);
+    bool TryResize(void* block, size_t old_bytes, size_t new_bytes);
+
+    std::vector<unsigned char*> m_blocks;
+    unsigned char* m_next = nullptr;
+    unsigned char* m_end = nullptr;
+    void* m_last = nullptr;
+    size_t m_block_size;
+    size_t m_reserved = 0;
+    size_t m_used = 0;
+};
+
+/**
+ * Makes an arena current on this thread for the lifetime of the scope, so that
+ * tree-sitter allocations made in the meantime are carved out of it. Scopes
+ * nest; the previous arena is restored on destruction. A null arena sends
+ * allocations back to the heap.
+ */
+class CTSArenaScope
+{
+public:
+    CTSArenaScope(const CTSArenaScope&) = delete;
+    CTSArenaScope(const CTSArenaScope&&) = delete;
+    CTSArenaScope operator=(const CTSArenaScope&) = delete;
+    CTSArenaScope operator=(const CTSArenaScope&&) = delete;
+
+    CTSArenaScope(CTSArena* arena);
+    ~CTSArenaScope();
+
+private:
+    CTSArena* m_previous;
+};
+
+/**
+ * Process-wide memory accounting for tree-sitter, built on `ts_set_allocator`.
+ */
+class CTSMemory
+{
+public:
+    /**
+     * Route all tree-sitter allocations through counting allocators.
+     *
+     * This must be called before any tree-sitter object (parser, tree, query,
+     * cursor) is created, because blocks allocated before installation cannot
+     * be freed through the counting allocator. It cannot be undone. Calling it
+     * again has no effect.
+     *
+     * When pool_small_blocks is true, blocks of up to `CTSMemory::MaxPooledSize`
+     * bytes are rounded up to a size class and, once freed, kept in a free list
+     * of the freeing thread for reuse instead of going back to the heap. Parsers
+     * allocate and drop large numbers of small nodes, so this takes most of that
+     * traffic off the shared heap when many threads parse at once.
+     *
+     * Once installed, buffers that tree-sitter returns to its caller must be
+     * released with `ts_current_free`; see `CTSArena`.
+     */
+    static void Install(bool pool_small_blocks = false);
+
+    /**
+     * Returns true once `CTSMemory::Install` has been called.
+     */
+    static bool IsInstalled();
+
+    /**
+     * Get the number of bytes tree-sitter currently has allocated, across all accounts.
+     */
+    static size_t TotalBytes();
+
+    /**
+     * Get the number of blocks tree-sitter currently has allocated, across all accounts.
+     */
+    static size_t TotalAllocations();
+
+    /**
+     * Get the account that is current on the calling thread, or nullptr.
+     */
+    static CTSMemoryAccount* CurrentAccount();
+
+    /**
+     * Get the arena that is current on the calling thread, or nullptr.
+     */
+    static CTSArena* CurrentArena();
+
+    /**
+     * The largest request served from the size-class pools.
+     */
+    static constexpr size_t MaxPooledSize = 512;
+
+    /**
+     * Get the number of bytes held in the calling thread's free lists.
+     */
+    static size_t ThreadPoolBytes();
+
+    /**
+     * Return the blocks held in the calling thread's free lists to the heap.
+     * Worker threads can call this after a burst of parsing to lower RSS; the
+     * lists are trimmed automatically when a thread exits.
+     */
+    static void TrimThreadPool();
+
+private:
+    friend class CTSMemoryScope;
+    friend class CTSArenaScope;
+
+    static void* Allocate(size_t size, CTSMemoryAccount* account);
+
+    static void* Malloc(size_t size);
+    static void* Calloc(size_t count, size_t size);
+    static void* Realloc(void* ptr, size_t size);
+    static void Free(void* ptr);
+};
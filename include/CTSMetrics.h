@@ -0,0 +1,263 @@
+#pragma once
+
+#include "api.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * What a `CTSParser` reports to its metrics sink after each parse, and what
+ * `CTSTree::ParseStats` returns for trees parsed while a sink was installed.
+ */
+struct CTSParseStats
+{
+    /**
+     * Time spent inside tree-sitter producing the tree.
+     */
+    std::chrono::nanoseconds wall_time{ 0 };
+
+    /**
+     * Number of bytes the parser was given: the length of the string for
+     * `CTSParser::ParseString` and `CTSParser::ParseFile`, otherwise the
+     * offset one past the furthest byte read from the input. With included
+     * ranges set, this is not the same as the end of the tree's root node.
+     */
+    uint32_t bytes = 0;
+
+    /**
+     * True if an old tree was passed for reuse.
+     */
+    bool incremental = false;
+
+    /**
+     * False if the parse produced no tree (timeout, cancellation, no language).
+     */
+    bool succeeded = false;
+
+    /**
+     * True if the tree contains syntax errors.
+     */
+    bool has_error = false;
+
+    /**
+     * Node counts. These are only filled in when the sink asks for them (see
+     * `CTSMetricsSink::WantsNodeCounts`), since they require walking the whole
+     * tree. reused_node_count is the number of nodes shared with the old tree.
+     */
+    uint32_t node_count = 0;
+    uint32_t reused_node_count = 0;
+    uint32_t error_node_count = 0;
+    uint32_t missing_node_count = 0;
+
+    /**
+     * The file being parsed by `CTSParser::ParseFile`, or empty. Only valid
+     * during the `CTSMetricsSink::OnParse` call.
+     */
+    std::string_view path;
+
+    double BytesPerSecond() const
+    {
+        return wall_time.count() ? static_cast<double>(bytes) * 1e9 / static_cast<double>(wall_time.count()) : 0.0;
+    }
+
+    double ReuseRatio() const
+    {
+        return node_count ? static_cast<double>(reused_node_count) / node_count : 0.0;
+    }
+};
+
+/**
+ * What a `CTSQueryCursor` reports to its metrics sink for each execution, once
+ * it has run out of results or is restarted or destroyed.
+ */
+struct CTSQueryStats
+{
+    /**
+     * The query that ran, identified by `CTSQuery::SourceHash` and its
+     * pattern count, and the byte range of the node it ran on. The query
+     * itself may be gone by the time the statistics are reported.
+     */
+    uint64_t query_hash = 0;
+    uint32_t pattern_count = 0;
+    uint32_t start_byte = 0;
+    uint32_t end_byte = 0;
+
+    /**
+     * Time spent inside tree-sitter executing the query, not counting the
+     * time the caller spent between calls.
+     */
+    std::chrono::nanoseconds wall_time{ 0 };
+
+    /**
+     * Number of calls that advanced the cursor, and what they produced.
+     */
+    uint32_t steps = 0;
+    uint32_t matches = 0;
+    uint32_t captures = 0;
+
+    /**
+     * Number of matches dropped because they failed the query's text predicates.
+     */
+    uint32_t predicate_rejections = 0;
+
+    /**
+     * See `CTSQueryCursor::DidExceedMatchLimit`.
+     */
+    bool exceeded_match_limit = false;
+};
+
+/**
+ * Receives parse and query statistics.
+ *
+ * Install a sink with `CTSParser::SetMetricsSink` or
+ * `CTSQueryCursor::SetMetricsSink`. Without a sink, the only cost is a null
+ * pointer check per call; clocks are not even read. Sinks shared between
+ * parsers or cursors used on different threads must be thread-safe.
+ */
+class CTSMetricsSink
+{
+public:
+    virtual ~CTSMetricsSink() = default;
+
+    virtual void OnParse(const CTSParseStats& stats) { (void)stats; }
+    virtual void OnQuery(const CTSQueryStats& stats) { (void)stats; }
+
+    /**
+     * Return true to have the node counts of `CTSParseStats` filled in.
+     *
+     * This is off by default because it is not cheap: every parse then walks
+     * the whole new tree, and an incremental parse also walks the old tree and
+     * hashes the ids of its nodes to find the shared ones. That turns a
+     * reparse that only touched the edited region into work proportional to
+     * the size of the document.
+     */
+    virtual bool WantsNodeCounts() const { return false; }
+};
+
+/**
+ * A thread-safe histogram with fixed bucket bounds.
+ */
+class CTSHistogram
+{
+public:
+    CTSHistogram(const CTSHistogram&) = delete;
+    CTSHistogram(const CTSHistogram&&) = delete;
+    CTSHistogram operator=(const CTSHistogram&) = delete;
+    CTSHistogram operator=(const CTSHistogram&&) = delete;
+
+    /**
+     * Create a histogram whose buckets count the values up to each of the
+     * given ascending bounds; a final bucket takes everything larger.
+     */
+    CTSHistogram(std::vector<double> bounds);
+
+    /**
+     * Create bounds 1, 2, 4, ... up to and including the first power of two
+     * at or above max.
+     */
+    static std::vector<double> ExponentialBounds(double max);
+
+    void Record(double value);
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    double Sum() const;
+
+    /**
+     * Get the upper bound of the bucket that holds the given quantile (0..1),
+     * an estimate accurate to the bucket width.
+     */
+    double Quantile(double quantile) const;
+
+    /**
+     * Append the histogram in the Prometheus text format.
+     */
+    void Export(std::string& out, std::string_view name, std::string_view help) const;
+
+private:
+    std::vector<double> m_bounds;
+    std::vector<std::atomic<uint64_t>> m_buckets; // one more than bounds
+    std::atomic<uint64_t> m_count{ 0 };
+    std::atomic<uint64_t> m_sum_micro{ 0 };       // sum, in millionths
+};
+
+/**
+ * A metrics sink that aggregates everything it receives into counters and
+ * histograms, for export to a monitoring system. Thread-safe, so one registry
+ * can serve every parser and cursor of a process.
+ */
+class CTSMetricsRegistry : public CTSMetricsSink
+{
+public:
+    CTSMetricsRegistry(const CTSMetricsRegistry&) = delete;
+    CTSMetricsRegistry(const CTSMetricsRegistry&&) = delete;
+    CTSMetricsRegistry operator=(const CTSMetricsRegistry&) = delete;
+    CTSMetricsRegistry operator=(const CTSMetricsRegistry&&) = delete;
+
+    /**
+     * Create an empty registry. The error and missing node counters and the
+     * reuse histogram need node counts, which are only collected when
+     * node_counts is true; see `CTSMetricsSink::WantsNodeCounts` for the cost.
+     */
+    CTSMetricsRegistry(bool node_counts = false);
+    ~CTSMetricsRegistry() override = default;
+
+    void OnParse(const CTSParseStats& stats) override;
+    void OnQuery(const CTSQueryStats& stats) override;
+    bool WantsNodeCounts() const override { return m_node_counts; }
+
+    /**
+     * Counters.
+     */
+    uint64_t Parses() const { return m_parses.load(std::memory_order_relaxed); }
+    uint64_t IncrementalParses() const { return m_incremental_parses.load(std::memory_order_relaxed); }
+    uint64_t FailedParses() const { return m_failed_parses.load(std::memory_order_relaxed); }
+    uint64_t ParsedBytes() const { return m_parsed_bytes.load(std::memory_order_relaxed); }
+    uint64_t TreesWithErrors() const { return m_trees_with_errors.load(std::memory_order_relaxed); }
+    uint64_t ErrorNodes() const { return m_error_nodes.load(std::memory_order_relaxed); }
+    uint64_t MissingNodes() const { return m_missing_nodes.load(std::memory_order_relaxed); }
+    uint64_t Queries() const { return m_queries.load(std::memory_order_relaxed); }
+    uint64_t QuerySteps() const { return m_query_steps.load(std::memory_order_relaxed); }
+    uint64_t QueryMatches() const { return m_query_matches.load(std::memory_order_relaxed); }
+    uint64_t QueryCaptures() const { return m_query_captures.load(std::memory_order_relaxed); }
+    uint64_t PredicateRejections() const { return m_predicate_rejections.load(std::memory_order_relaxed); }
+    uint64_t MatchLimitExceeded() const { return m_match_limit_exceeded.load(std::memory_order_relaxed); }
+
+    /**
+     * Histograms: parse and query durations in microseconds, and the
+     * percentage of nodes reused by incremental parses.
+     */
+    const CTSHistogram& ParseDuration() const { return m_parse_duration; }
+    const CTSHistogram& QueryDuration() const { return m_query_duration; }
+    const CTSHistogram& ReusePercent() const { return m_reuse_percent; }
+
+    /**
+     * Render every counter and histogram in the Prometheus text format, with
+     * names prefixed by "tswrapper_".
+     */
+    std::string ExportText() const;
+
+private:
+    bool m_node_counts;
+
+    std::atomic<uint64_t> m_parses{ 0 };
+    std::atomic<uint64_t> m_incremental_parses{ 0 };
+    std::atomic<uint64_t> m_failed_parses{ 0 };
+    std::atomic<uint64_t> m_parsed_bytes{ 0 };
+    std::atomic<uint64_t> m_trees_with_errors{ 0 };
+    std::atomic<uint64_t> m_error_nodes{ 0 };
+    std::atomic<uint64_t> m_missing_nodes{ 0 };
+    std::atomic<uint64_t> m_queries{ 0 };
+    std::atomic<uint64_t> m_query_steps{ 0 };
+    std::atomic<uint64_t> m_query_matches{ 0 };
+    std::atomic<uint64_t> m_query_captures{ 0 };
+    std::atomic<uint64_t> m_predicate_rejections{ 0 };
+    std::atomic<uint64_t> m_match_limit_exceeded{ 0 };
+
+    CTSHistogram m_parse_duration;
+    CTSHistogram m_query_duration;
+    CTSHistogram m_reuse_percent;
+};
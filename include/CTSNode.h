@@ -1,6 +1,7 @@
 #pragma once
 #include "api.h"
 #include <string>
+#include <string_view>
 
 class CTSNode : public TSNode
 {
@@ -20,6 +21,15 @@ public:
      */
     std::string Type() const;
 
+    /**
+     * Get the node's type without allocating.
+     *
+     * The view points into static storage owned by the language. When the
+     * `CTSLanguage` is at hand, `CTSLanguage::SymbolNameView(node.Symbol())`
+     * returns the same text from a precomputed table.
+     */
+    std::string_view TypeView() const;
+
     /**
      * Get the node's type as a numerical id.
      */
@@ -108,6 +118,14 @@ public:
      */
     std::string FieldNameForChild(uint32_t index = 0, bool* was_found = nullptr) const;
 
+    /**
+     * Get the field name for node's child at the given index without allocating.
+     *
+     * Behaves like `CTSNode::FieldNameForChild`, but returns a view into static
+     * storage owned by the language.
+     */
+    std::string_view FieldNameViewForChild(uint32_t index = 0, bool* was_found = nullptr) const;
+
     /**
      * Get the node's number of children.
      */
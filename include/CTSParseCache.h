@@ -0,0 +1,171 @@
+#pragma once
+
+#include "api.h"
+#include "CTSFlatTree.h"
+#include "CTSParser.h"
+#include "CTSTree.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * Counters reported by `CTSParseCache::Stats`.
+ */
+struct CTSParseCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    /**
+     * Number of parses run on behalf of callers. This can exceed misses when
+     * several threads miss on the same content at once.
+     */
+    uint64_t parses = 0;
+
+    /**
+     * Flat trees read from and written to the disk directory.
+     */
+    uint64_t disk_hits = 0;
+    uint64_t disk_writes = 0;
+};
+
+/**
+ * A thread-safe, content-addressed cache of syntax trees.
+ *
+ * Entries are keyed by the parser's language (`CTSLanguage::Fingerprint`),
+ * its included ranges and the `CTSContentHash` and length of the source, so
+ * byte-identical files share one parse. `CTSParseCache::Parse` hands back a
+ * shallow copy of the cached tree (see `CTSTree::Copy`): every caller shares
+ * its nodes, and may use or even edit its copy on any thread without
+ * affecting the others. Content is identified by its 64-bit hash and length
+ * alone; the source itself is not kept.
+ *
+ * The cache is bounded by the memory its trees hold, as reported by
+ * `CTSTree::MemoryUsage` (exact when `CTSMemory` is installed, estimated
+ * otherwise). The least recently used trees are evicted first; trees handed
+ * out stay valid regardless.
+ *
+ * Trees cannot be rebuilt outside tree-sitter, so the optional disk directory
+ * holds serialized `CTSFlatTree` snapshots instead (see `CTSFlatTree::Save`).
+ * `CTSParseCache::ParseFlat` looks there before parsing and writes new
+ * snapshots there after, so processes pointed at the same directory share
+ * their work.
+ */
+class CTSParseCache
+{
+public:
+    static constexpr size_t DefaultMaxBytes = 256 << 20;
+
+    CTSParseCache(const CTSParseCache&) = delete;
+    CTSParseCache(const CTSParseCache&&) = delete;
+    CTSParseCache operator=(const CTSParseCache&) = delete;
+    CTSParseCache operator=(const CTSParseCache&&) = delete;
+
+    /**
+     * Create a cache whose trees hold at most max_bytes. When disk_directory
+     * is not empty, it must exist; flat trees are stored there.
+     */
+    CTSParseCache(size_t max_bytes = DefaultMaxBytes, std::string disk_directory = std::string());
+
+    ~CTSParseCache() = default;
+
+    /**
+     * Get a tree for the source, parsing it with parser on a miss. The lock
+     * is not held while parsing. Returns nullptr if the parse fails; failures
+     * are not cached.
+     */
+    std::shared_ptr<CTSTree> Parse(const CTSParser& parser, std::string_view source);
+
+    /**
+     * Get a tree for the source if one is cached, without parsing.
+     */
+    std::shared_ptr<CTSTree> Find(const CTSParser& parser, std::string_view source);
+
+    /**
+     * Get a flat tree for the source: from the disk directory if a matching
+     * snapshot is there, otherwise flattened from `CTSParseCache::Parse` and
+     * written to the directory. Without a directory this is just a flattened
+     * `CTSParseCache::Parse`. Returns nullptr if the parse fails.
+     */
+    std::shared_ptr<CTSFlatTree> ParseFlat(const CTSParser& parser, std::string_view source);
+
+    /**
+     * Get the memory held by cached trees, and the limit.
+     */
+    size_t Bytes() const;
+    size_t MaxBytes() const;
+
+    /**
+     * Change the memory limit, evicting as needed.
+     */
+    void SetMaxBytes(size_t max_bytes);
+
+    /**
+     * Get the number of cached trees.
+     */
+    size_t Size() const;
+
+    /**
+     * Drop every cached tree. The disk directory is left alone.
+     */
+    void Clear();
+
+    /**
+     * Get a snapshot of the cache's counters.
+     */
+    CTSParseCacheStats Stats() const;
+
+private:
+    struct Key
+    {
+        uint64_t language;
+        uint64_t ranges;
+        uint64_t content;
+        size_t length;
+
+        bool operator==(const Key& other) const
+        {
+            return (language == other.language) && (ranges == other.ranges) &&
+                   (content == other.content) && (length == other.length);
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return static_cast<size_t>(key.content ^ (key.ranges * 0x9e3779b97f4a7c15ULL) ^ key.language);
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<CTSTree> tree;
+        size_t bytes;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    static Key MakeKey(const CTSParser& parser, std::string_view source);
+    std::string DiskPath(const Key& key) const;
+    std::shared_ptr<CTSTree> Lookup(const Key& key);
+    void EvictLocked();
+
+    mutable std::mutex m_mutex;
+    size_t m_max_bytes;
+    size_t m_bytes = 0;
+    std::string m_disk_directory;
+
+    // Most recently used first.
+    EntryList m_entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> m_index;
+
+    CTSParseCacheStats m_stats;
+};
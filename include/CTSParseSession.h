@@ -0,0 +1,70 @@
+#pragma once
+
+#include "api.h"
+#include "CTSMemory.h"
+#include "CTSParser.h"
+
+#include <memory>
+
+/**
+ * A scoped parse session: a `CTSParser` whose allocations, and those of every
+ * tree it produces, come from one `CTSArena`.
+ *
+ * Trees parsed through the session are freed without touching the heap, and
+ * their memory goes back to the system at once, when the session has been
+ * reset or destroyed and the last of its trees has been dropped. Use one
+ * session per thread, and reset it between batches of related documents so
+ * that the arena does not keep growing.
+ *
+ * The arena is only used when `CTSMemory` is installed; otherwise the session
+ * behaves like a plain parser.
+ */
+class CTSParseSession
+{
+public:
+    CTSParseSession() = delete;
+    CTSParseSession(const CTSParseSession&) = delete;
+    CTSParseSession(const CTSParseSession&&) = delete;
+    CTSParseSession operator=(const CTSParseSession&) = delete;
+    CTSParseSession operator=(const CTSParseSession&&) = delete;
+
+    /**
+     * Start a session for the given language. Check
+     * `CTSParseSession::LanguageSetResult()` to make sure the language was
+     * accepted.
+     */
+    CTSParseSession(const TSLanguage* language, size_t arena_block_size = CTSArena::DefaultBlockSize);
+
+    ~CTSParseSession() = default;
+
+    /**
+     * Returns the result of setting the language, see `CTSParser::LanguageSetResult`.
+     */
+    bool LanguageSetResult() const { return m_parser->LanguageSetResult(); }
+
+    /**
+     * Get the session's parser. Everything it parses is allocated from the
+     * session's arena.
+     */
+    const CTSParser& Parser() const { return *m_parser; }
+
+    /**
+     * Get the arena backing the current round of the session.
+     */
+    const CTSArena& Arena() const { return *m_arena; }
+
+    /**
+     * End the current round: drop the parser and the session's hold on the
+     * arena, and start over with a fresh parser and arena. The old arena is
+     * released as soon as no tree parsed before the reset is alive.
+     */
+    void Reset();
+
+private:
+    const TSLanguage* m_language;
+    size_t m_block_size;
+
+    // The parser is declared after the arena so that it is destroyed first.
+    std::shared_ptr<CTSArena> m_arena;
+    std::unique_ptr<CTSParser> m_parser;
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "api.h"
+#include "CTSCancellationToken.h"
+#include "CTSInputSource.h"
+#include "CTSParser.h"
+#include "CTSTree.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+/**
+ * State of a `CTSParseTask`.
+ */
+enum class CTSParseStatus
+{
+    Pending,          // not run yet
+    Suspended,        // the last time slice ran out; run again to resume
+    Completed,        // the tree is available
+    Cancelled,        // the token was cancelled
+    DeadlineExceeded, // the token's deadline passed
+    Failed            // the parser has no language, or the input could not be read
+};
+
+/**
+ * One parse that can be run in time slices, cancelled, and monitored.
+ *
+ * tree-sitter can halt a parse part way through and pick it up again on the
+ * next call with the same input, as long as the parser is not used for
+ * anything else in between. A CTSParseTask holds on to the input and the old
+ * tree so that `CTSParseTask::RunFor` and `CTSParseTask::RunUntil` can be
+ * called repeatedly, each call continuing where the previous one stopped
+ * instead of starting over. This keeps a worker thread responsive while it
+ * works through a very large document.
+ *
+ * The task borrows the parser until it finishes or is destroyed; a task that
+ * is abandoned resets the parser so that its next parse starts from scratch.
+ * The parser's own timeout and cancellation flag are restored after each call.
+ *
+ * If the parser has a metrics sink, the task reports the parse to it once,
+ * when the task finishes or is abandoned, with the wall time of all its
+ * slices together. Suspended slices are not reported on their own.
+ */
+class CTSParseTask
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Called with the offset one past the furthest byte the parser has read so
+     * far, each time it advances. Text is handed to the parser in chunks of
+     * `CTSParseTask::ProgressChunkSize` bytes, which sets the granularity.
+     */
+    using ProgressCallback = std::function<void(uint32_t bytes_consumed)>;
+
+    static constexpr uint32_t ProgressChunkSize = 1 << 16;
+
+    CTSParseTask() = delete;
+    CTSParseTask(const CTSParseTask&) = delete;
+    CTSParseTask(const CTSParseTask&&) = delete;
+    CTSParseTask operator=(const CTSParseTask&) = delete;
+    CTSParseTask operator=(const CTSParseTask&&) = delete;
+
+    /**
+     * Prepare a parse of text, which must stay alive and unchanged until the
+     * task is finished. old_tree is the same as in `CTSParser::Parse`. If the
+     * text is the contents of a file, path can name it; it is reported to the
+     * parser's metrics sink as `CTSParseStats::path`, as `CTSParser::ParseFile`
+     * does, and must also outlive the task.
+     */
+    CTSParseTask(const CTSParser& parser,
+                 std::string_view text,
+                 std::shared_ptr<CTSTree> old_tree = nullptr,
+                 CTSCancellationToken token = CTSCancellationToken(),
+                 std::string_view path = {});
+
+    /**
+     * Prepare a parse of text read from source, which must outlive the task.
+     */
+    CTSParseTask(const CTSParser& parser,
+                 CTSInputSource& source,
+                 std::shared_ptr<CTSTree> old_tree = nullptr,
+                 CTSCancellationToken token = CTSCancellationToken());
+
+    /**
+     * Resets the parser if the task was left suspended.
+     */
+    ~CTSParseTask();
+
+    void SetProgressCallback(ProgressCallback callback) { m_progress = std::move(callback); }
+
+    /**
+     * Run until the parse is finished, cancelled or the token's deadline passes.
+     */
+    CTSParseStatus Run() { return RunUntil(Clock::time_point::max()); }
+
+    /**
+     * Run until the parse is finished or the given deadline passes, whichever
+     * comes first. In the latter case the task is suspended, and calling this
+     * method again resumes it. The token's deadline, by contrast, ends the task.
+     */
+    CTSParseStatus RunUntil(Clock::time_point deadline);
+
+    /**
+     * Run for at most the given time slice. See `CTSParseTask::RunUntil`.
+     */
+    CTSParseStatus RunFor(std::chrono::microseconds slice) { return RunUntil(Clock::now() + slice); }
+
+    CTSParseStatus Status() const { return m_status; }
+
+    /**
+     * Returns true once the task can make no further progress: it completed,
+     * was cancelled, ran past its deadline or failed.
+     */
+    bool IsFinished() const { return (m_status != CTSParseStatus::Pending) && (m_status != CTSParseStatus::Suspended); }
+
+    /**
+     * Get the tree once the task has completed, otherwise nullptr.
+     */
+    const std::shared_ptr<CTSTree>& Tree() const { return m_tree; }
+
+    /**
+     * Get the offset one past the furthest byte the parser has read.
+     */
+    uint32_t BytesConsumed() const { return m_bytes_consumed; }
+
+    /**
+     * Get the length of the text, or zero when reading from a `CTSInputSource`.
+     */
+    uint32_t TotalBytes() const { return static_cast<uint32_t>(m_text.size()); }
+
+    /**
+     * Get the number of times the parser has been run.
+     */
+    uint32_t SliceCount() const { return m_slices; }
+
+    const CTSCancellationToken& Token() const { return m_token; }
+
+private:
+    static const char* Read(void* payload, uint32_t byte, TSPoint point, uint32_t* bytes_read);
+
+    CTSParseStatus Finish(CTSParseStatus status);
+    void Record() const;
+
+    const CTSParser& m_parser;
+    std::string_view m_text;
+    std::string_view m_path;
+    CTSInputSource* m_source = nullptr;
+    TSInput m_source_input{};
+    std::shared_ptr<CTSTree> m_old_tree;
+    CTSCancellationToken m_token;
+    ProgressCallback m_progress;
+
+    std::shared_ptr<CTSTree> m_tree;
+    CTSParseStatus m_status = CTSParseStatus::Pending;
+    uint32_t m_bytes_consumed = 0;
+    uint32_t m_slices = 0;
+    std::chrono::nanoseconds m_wall_time{ 0 };
+
+    // Every slice is charged to this account, so the finished tree accounts
+    // for the whole parse rather than its last slice.
+    CTSMemoryAccount* m_account = nullptr;
+};
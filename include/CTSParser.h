@@ -1,11 +1,16 @@
 #pragma once
 
 #include "api.h"
+#include "CTSInputSource.h"
 #include "CTSLanguage.h"
+#include "CTSMemory.h"
+#include "CTSMetrics.h"
 #include "CTSTree.h"
 
+#include <chrono>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct CTSParser
@@ -24,6 +29,23 @@ public:
      */
     CTSParser(const TSLanguage* language);
 
+    /**
+     * Create a new parser whose allocations, and those of every tree it
+     * produces, are carved out of the given arena (see `CTSArena`). The parser
+     * and each of its trees keep the arena alive, so its memory is released
+     * once the last of them is gone.
+     *
+     * The arena is only used when `CTSMemory` is installed. The parser must
+     * still be used by one thread at a time, and the arena should not be
+     * shared with parsers used on other threads.
+     */
+    CTSParser(const TSLanguage* language, std::shared_ptr<CTSArena> arena);
+
+    /**
+     * Get the arena the parser allocates from, or nullptr.
+     */
+    CTSArena* Arena() const { return m_arena.get(); }
+
     /**
      * Delete the parser, freeing all of the memory that it used.
      */
@@ -120,19 +142,107 @@ public:
      * */
     std::shared_ptr<CTSTree> Parse(TSInput input) const;
 
+    /**
+     * Use the parser to parse source code supplied in chunks by a `CTSInputSource`,
+     * such as a piece table, a rope or a stream.
+     *
+     * This is an overloaded method. See other entry for Parse() for full details.
+     * */
+    std::shared_ptr<CTSTree> Parse(const std::shared_ptr<CTSTree>& old_tree, CTSInputSource& source) const;
+
+    /**
+     * Use the parser to parse source code supplied in chunks by a `CTSInputSource`
+     * and create an initial syntax tree.
+     *
+     * This is an overloaded method. See other entry for Parse() for full details.
+     * */
+    std::shared_ptr<CTSTree> Parse(CTSInputSource& source) const;
+
     /**
      * Use the parser to parse some source code stored in one contiguous buffer.
      * The old_tree parameter, when present, is the same as in the `TSParser::Parse` method
-     * above. The second parameters is a string containing the contents to be parsed.
+     * above. The second parameters is a view of the contents to be parsed.
+     *
+     * The buffer is read in place and is not copied. It only needs to stay alive
+     * until this method returns.
+     *
+     * Returns nullptr if the buffer is larger than 4 GiB, the most
+     * tree-sitter can address.
      */
-    std::shared_ptr<CTSTree> ParseString(const std::shared_ptr<CTSTree>&, const std::string& str) const;  
+    std::shared_ptr<CTSTree> ParseString(const std::shared_ptr<CTSTree>&, std::string_view str) const;
 
     /**
      * Use the parser to parse a string containing source code and create an initial syntax tree.
      *
      * This is an overloaded method. See other entry for ParseString() for full details.
      * */
-    std::shared_ptr<CTSTree> ParseString(const std::string& str) const;
+    std::shared_ptr<CTSTree> ParseString(std::string_view str) const;
+
+    /**
+     * Use the parser to parse `length` bytes of source code starting at `str`.
+     *
+     * This is an overloaded method. See other entry for ParseString() for full details.
+     * */
+    std::shared_ptr<CTSTree> ParseString(const std::shared_ptr<CTSTree>& old_tree, const char* str, uint32_t length) const;
+
+    /**
+     * Use the parser to parse `length` bytes of source code starting at `str` and create
+     * an initial syntax tree.
+     *
+     * This is an overloaded method. See other entry for ParseString() for full details.
+     * */
+    std::shared_ptr<CTSTree> ParseString(const char* str, uint32_t length) const;
+
+    /**
+     * Use the parser to parse the contents of a file.
+     *
+     * The file is memory-mapped for the duration of the parse and its contents are
+     * handed to the parser directly, without being copied into an intermediate
+     * buffer. The old_tree parameter is the same as in the `CTSParser::Parse` method.
+     *
+     * Returns nullptr if the file cannot be opened or mapped, if it is larger than
+     * 4 GiB, or if parsing fails for any of the reasons listed under `CTSParser::Parse`.
+     */
+    std::shared_ptr<CTSTree> ParseFile(const std::shared_ptr<CTSTree>& old_tree, const std::string& path) const;
+
+    /**
+     * Use the parser to parse the contents of a file and create an initial syntax tree.
+     *
+     * This is an overloaded method. See other entry for ParseFile() for full details.
+     * */
+    std::shared_ptr<CTSTree> ParseFile(const std::string& path) const;
+
+    /**
+     * Incrementally reparse a document after it has been edited.
+     *
+     * Every edit in `edits` is applied, in order, to old_tree using `CTSTree::Edit()`,
+     * and old_tree is then handed to `CTSParser::Parse` so that the unchanged parts
+     * of it are reused. The edits must exactly describe how the text read through
+     * `input` differs from the text old_tree was parsed from. Note that old_tree is
+     * modified in place; use `CTSTree::Copy` first if the unedited tree is still
+     * needed elsewhere.
+     *
+     * If changed_ranges is given, it receives the ranges whose syntactic structure
+     * differs between the edited old tree and the new tree, as reported by
+     * `CTSTree::GetChangedRanges`. If old_tree is nullptr, the whole document
+     * is reported as changed.
+     *
+     * Returns the new tree, or nullptr on failure. See `CTSParser::Parse`.
+     */
+    std::shared_ptr<CTSTree> Reparse(const std::shared_ptr<CTSTree>& old_tree,
+                                     const std::vector<TSInputEdit>& edits,
+                                     TSInput input,
+                                     std::vector<TSRange>* changed_ranges = nullptr) const;
+
+    /**
+     * Incrementally reparse a document held in one contiguous buffer.
+     *
+     * This is an overloaded method. See the other entry for Reparse() for full details.
+     */
+    std::shared_ptr<CTSTree> ReparseString(const std::shared_ptr<CTSTree>& old_tree,
+                                           const std::vector<TSInputEdit>& edits,
+                                           std::string_view str,
+                                           std::vector<TSRange>* changed_ranges = nullptr) const;
 
 #ifdef HANDLE_UTF
 	TSTree* ParseStringEncoding(const char* str, uint32_t length, TSInputEncoding encoding)
@@ -203,6 +313,24 @@ public:
      */
     void PrintDotGraphs(int file) const;
 
+    /**
+     * Set the sink that receives a `CTSParseStats` record after every parse,
+     * or pass nullptr to stop collecting. The statistics are also attached to
+     * the resulting tree (see `CTSTree::ParseStats`).
+     *
+     * The parser does not take ownership of the sink, which must outlive it
+     * or be removed first. Without a sink, parsing does no extra work. With
+     * one, every parse reads the clock twice; only if the sink opts in through
+     * `CTSMetricsSink::WantsNodeCounts` does it also walk the new tree (and,
+     * for incremental parses, the old one) to count nodes.
+     */
+    void SetMetricsSink(CTSMetricsSink* sink) { m_metrics = sink; }
+
+    /**
+     * Get the parser's current metrics sink, or nullptr.
+     */
+    CTSMetricsSink* MetricsSink() const { return m_metrics; }
+
     /** Returns the current language version contained in the library macro
      * TREE_SITTER_LANGUAGE_VERSION.  This is used in validating languages set
      * in the constructor.  See 'CTSParser::CTSParser()' for details.
@@ -215,11 +343,52 @@ public:
      */
     static uint32_t MinCompatibleLanguageVersion() { return TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION; }
 
+    /**
+     * Get the number of bytes charged to the parser itself: what it allocated
+     * while being created or configured. Memory allocated during a parse,
+     * including buffers the parser keeps afterwards, is charged to the tree
+     * that parse produced (see `CTSTree::MemoryUsage`).
+     *
+     * Only available when `CTSMemory` is installed; returns zero otherwise.
+     */
+    size_t MemoryUsage() const { return m_account ? m_account->Bytes() : 0; }
+
 private:
+    friend class CTSParseTask;
+
     bool SetLanguage(const TSLanguage* language);
 
+    // Parse without reporting to the metrics sink, for callers that report
+    // the parse themselves. The second form charges the parse to the given
+    // account and takes over one reference to it, for callers that spread
+    // one parse over several calls.
+    std::shared_ptr<CTSTree> ParseUnrecorded(const std::shared_ptr<CTSTree>& old_tree, TSInput input) const;
+    std::shared_ptr<CTSTree> ParseUnrecorded(const std::shared_ptr<CTSTree>& old_tree, TSInput input,
+                                             CTSMemoryAccount* account) const;
+
+    std::shared_ptr<CTSTree> WrapTree(TSTree* tree, CTSMemoryAccount* account) const;
+    void RetainArenas(const std::shared_ptr<CTSTree>& old_tree) const;
+    void RecordParse(const std::shared_ptr<CTSTree>& old_tree,
+                     const std::shared_ptr<CTSTree>& new_tree,
+                     uint32_t bytes,
+                     std::chrono::nanoseconds wall_time) const;
+    static void FillChangedRanges(const std::shared_ptr<CTSTree>& old_tree,
+                                  const std::shared_ptr<CTSTree>& new_tree,
+                                  std::vector<TSRange>* changed_ranges);
+
     bool m_set_lang_result;
 
     TSParser* m_self = nullptr;
     CTSLanguage* m_lang;
+    CTSMemoryAccount* m_account = nullptr;
+    std::shared_ptr<CTSArena> m_arena;
+    CTSMetricsSink* m_metrics = nullptr;
+
+    // The file being parsed by ParseFile, reported in CTSParseStats::path.
+    mutable std::string_view m_metrics_path;
+
+    // Arenas whose blocks may end up in the parser's internal pools, through
+    // its own allocations or through old trees it reparsed. Every tree the
+    // parser produces keeps these alive as well.
+    mutable std::vector<std::shared_ptr<CTSArena>> m_arenas;
 };
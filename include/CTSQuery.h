@@ -2,9 +2,12 @@
 
 #include "api.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "CTSLanguage.h"
+#include "CTSMemory.h"
+#include "CTSSymbolTable.h"
 
 
 struct  CTSQuery
@@ -32,7 +35,14 @@ public:
 
     CTSQuery(const CTSLanguage* lang, const char* oldstr);
 
-    // CTSQuery(const CTSLanguage *lang, std::string &pattern);
+    /**
+     * Create a new query for the given language from the source text. The
+     * text is handed to tree-sitter as is, without being copied first.
+     *
+     * See the other constructor for details. To share compiled queries
+     * between requests, see `CTSQueryCache`.
+     */
+    CTSQuery(const TSLanguage* language, std::string_view source);
 
     /**
      * Delete a query, freeing all of the memory that it used.
@@ -90,6 +100,26 @@ public:
      */
     bool IsPatternGuaranteedAtStep(uint32_t byte_offset) const;
 
+    /**
+     * Get the `CTSContentHash` of the query's source, which identifies the
+     * query across processes, for instance in metrics.
+     */
+    uint64_t SourceHash() const { return m_source_hash; }
+
+    /**
+     * Get the symbols that the query's patterns start at: the node types at
+     * the top of each pattern, read from the query source when the query was
+     * created. The set is only complete if `CTSQuery::HasUnrestrictedRoots`
+     * returns false.
+     */
+    const CTSSymbolSet& RootSymbols() const { return m_root_symbols; }
+
+    /**
+     * Returns true if some pattern can start at a node of any type, because
+     * it starts with a wildcard such as `(_)` or is not rooted in a single node.
+     */
+    bool HasUnrestrictedRoots() const { return m_unrestricted_roots; }
+
     /**
      * Get the name of one of the query's captures, or one of the query's string
      * literals. Each capture and string is associated with a numeric id based
@@ -162,12 +192,27 @@ public:
 
     std::string DecodeLastErrorCode() const { return DecodeQueryError(GetErrorCode()); }
 
+    /**
+     * Get the number of bytes the compiled query currently has allocated.
+     *
+     * Only available when `CTSMemory` is installed; returns zero otherwise.
+     */
+    size_t MemoryUsage() const { return m_account ? m_account->Bytes() : 0; }
+
 
     friend class CTSQueryCursor;
 
     TSQuery* RawQuery() const { return m_query; }
 private:
+    CTSQuery(const TSLanguage* language, const CTSLanguage* tables, std::string_view source);
+
+    void FindRootSymbols(const TSLanguage* language, const CTSLanguage* tables, std::string_view source);
+
     uint32_t m_error_offset = 0;
     TSQueryError m_error_code = TSQueryErrorNone;
     TSQuery* m_query = nullptr;
+    CTSMemoryAccount* m_account = nullptr;
+    uint64_t m_source_hash = 0;
+    CTSSymbolSet m_root_symbols;
+    bool m_unrestricted_roots = false;
 };
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "api.h"
+#include "CTSLanguage.h"
+#include "CTSQuery.h"
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * Counters reported by `CTSQueryCache::Stats`.
+ */
+struct CTSQueryCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    /**
+     * Number of queries compiled, and the time spent compiling them. This can
+     * exceed misses when several threads miss on the same query at once.
+     */
+    uint64_t compilations = 0;
+    std::chrono::nanoseconds compile_time{ 0 };
+    std::chrono::nanoseconds max_compile_time{ 0 };
+};
+
+/**
+ * A thread-safe cache of compiled queries, keyed by language and query source.
+ *
+ * Compiling a large query takes milliseconds. Services that run the same
+ * highlight, tag or lint queries on every request can fetch them from a
+ * shared cache instead. `CTSQueryCache::Get` returns a shared, immutable
+ * handle; the query stays alive for as long as any caller holds it, even
+ * after it has been evicted. Any number of threads may run the same query at
+ * once, each with its own `CTSQueryCursor`. Do not call
+ * `CTSQuery::DisableCapture` or `CTSQuery::DisablePattern` on a cached query,
+ * as that would change it for every other user.
+ *
+ * When the cache is full, the least recently used query is evicted. Queries
+ * that fail to compile are cached as well, so check `CTSQuery::IsValid`.
+ */
+class CTSQueryCache
+{
+public:
+    CTSQueryCache(const CTSQueryCache&) = delete;
+    CTSQueryCache(const CTSQueryCache&&) = delete;
+    CTSQueryCache operator=(const CTSQueryCache&) = delete;
+    CTSQueryCache operator=(const CTSQueryCache&&) = delete;
+
+    /**
+     * Create a cache holding at most capacity queries.
+     */
+    CTSQueryCache(size_t capacity = 64);
+
+    ~CTSQueryCache() = default;
+
+    /**
+     * Get the compiled query for the source text, compiling it on a miss.
+     * The lock is not held while compiling, so a slow compilation does not
+     * block lookups of other queries.
+     */
+    std::shared_ptr<const CTSQuery> Get(const TSLanguage* language, std::string_view source);
+
+    /**
+     * This is an overloaded method. See other entry for Get() for full details.
+     */
+    std::shared_ptr<const CTSQuery> Get(const CTSLanguage* language, std::string_view source)
+    {
+        return Get(language->GetTSLanguage(), source);
+    }
+
+    /**
+     * Get the number of cached queries.
+     */
+    size_t Size() const;
+
+    /**
+     * Get the maximum number of cached queries.
+     */
+    size_t Capacity() const;
+
+    /**
+     * Change the maximum number of cached queries, evicting as needed.
+     */
+    void SetCapacity(size_t capacity);
+
+    /**
+     * Drop every cached query. Handles already returned stay valid.
+     */
+    void Clear();
+
+    /**
+     * Get a snapshot of the cache's counters.
+     */
+    CTSQueryCacheStats Stats() const;
+
+private:
+    struct Key
+    {
+        const TSLanguage* language;
+        uint64_t hash;
+        std::string_view source;
+
+        bool operator==(const Key& other) const
+        {
+            return (language == other.language) && (hash == other.hash) && (source == other.source);
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            return static_cast<size_t>(key.hash ^ (reinterpret_cast<uintptr_t>(key.language) * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+
+    struct Entry
+    {
+        const TSLanguage* language;
+        uint64_t hash;
+        std::string source;
+        std::shared_ptr<const CTSQuery> query;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void EvictLocked();
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+
+    // Most recently used first. The keys of m_index view the sources owned by
+    // the entries of m_entries.
+    EntryList m_entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> m_index;
+
+    CTSQueryCacheStats m_stats;
+};
@@ -3,6 +3,10 @@
 #include "api.h"
 #include "CTSQuery.h"
 #include "CTSNode.h"
+#include "CTSMetrics.h"
+#include "CTSQueryPredicates.h"
+#include "CTSQueryRange.h"
+#include "CTSQueryResults.h"
 
 class CTSQueryCursor
 {
@@ -121,6 +125,99 @@ public:
      */
     bool NextCapture(); // Get result w/ GetMatchResult() & GetCaptureIndex()
 
+    /**
+     * Advance to the next match of the currently running query that satisfies
+     * the query's text predicates. source is the text the tree was parsed from.
+     *
+     * Returns 'true' if a match occurred, otherwise returns 'false'. The match
+     * can be retrieved with 'CTSQueryCursor::GetMatchResult'.
+     */
+    bool NextMatch(const CTSQueryPredicates& predicates, std::string_view source);
+
+    /**
+     * Advance to the next capture of the currently running query whose match
+     * satisfies the query's text predicates. Matches that fail are removed
+     * from the cursor with 'CTSQueryCursor::RemoveMatch', so none of their
+     * other captures are returned either. source is the text the tree was
+     * parsed from.
+     *
+     * Returns 'true' if a capture occurred, otherwise returns 'false'. See
+     * 'CTSQueryCursor::NextCapture' for how to retrieve it.
+     */
+    bool NextCapture(const CTSQueryPredicates& predicates, std::string_view source);
+
+    /**
+     * Drain the remaining matches of the currently running query into results,
+     * one row per capture, grouped by match.
+     *
+     * The previous contents of results are cleared first, but its capacity is
+     * kept, so reusing one `CTSQueryResults` across executions avoids
+     * allocating per match. Returns the number of matches collected.
+     */
+    size_t CollectAll(CTSQueryResults& results);
+
+    /**
+     * Start running the query on the node, then drain all of its matches into
+     * results. See the other entry for CollectAll() for details.
+     */
+    size_t CollectAll(const CTSQuery& query, CTSNode node, CTSQueryResults& results);
+
+    /**
+     * Drain the remaining captures of the currently running query into results
+     * in the order `CTSQueryCursor::NextCapture` returns them. The match columns
+     * of results are left empty. Returns the number of captures collected.
+     */
+    size_t CollectAllCaptures(CTSQueryResults& results);
+
+    /**
+     * Start running the query on the node, then drain all of its captures into
+     * results. See the other entry for CollectAllCaptures() for details.
+     */
+    size_t CollectAllCaptures(const CTSQuery& query, CTSNode node, CTSQueryResults& results);
+
+    /**
+     * Get a lazy range over the remaining matches of the currently running
+     * query. Each step of the loop calls `CTSQueryCursor::NextMatch`, so
+     * breaking out early leaves the rest of the tree unsearched.
+     */
+    CTSQueryMatchRange Matches() { return { this }; }
+
+    /**
+     * Start running the query on the node and get a lazy range over its matches.
+     */
+    CTSQueryMatchRange Matches(const CTSQuery& query, CTSNode node)
+    {
+        Exec(query, node);
+        return { this };
+    }
+
+    /**
+     * Get a lazy range over the remaining matches that satisfy the predicates.
+     * See `CTSQueryCursor::NextMatch(const CTSQueryPredicates&, std::string_view)`.
+     */
+    CTSQueryMatchRange Matches(const CTSQueryPredicates& predicates, std::string_view source) { return { this, &predicates, source }; }
+
+    /**
+     * Get a lazy range over the remaining captures of the currently running
+     * query, in document order. See `CTSQueryCursor::NextCapture`.
+     */
+    CTSQueryCaptureRange Captures() { return { this }; }
+
+    /**
+     * Get a lazy range over the remaining captures of matches that satisfy the
+     * predicates. See `CTSQueryCursor::NextCapture(const CTSQueryPredicates&, std::string_view)`.
+     */
+    CTSQueryCaptureRange Captures(const CTSQueryPredicates& predicates, std::string_view source) { return { this, &predicates, source }; }
+
+    /**
+     * Start running the query on the node and get a lazy range over its captures.
+     */
+    CTSQueryCaptureRange Captures(const CTSQuery& query, CTSNode node)
+    {
+        Exec(query, node);
+        return { this };
+    }
+
     /**
      * Holds the most recent result found in either the 'CTSQueryCursor:NextMatch'
      * or 'CTSQueryCursor::NextCapture' method.
@@ -136,7 +233,33 @@ public:
      */
     TSQueryCursor& RawCursor() const { return *m_cursor; }
 
+    /**
+     * Set the sink that receives a `CTSQueryStats` record for every execution,
+     * or pass nullptr to stop collecting.
+     *
+     * An execution is reported once the cursor runs out of results, or when
+     * the next `CTSQueryCursor::Exec`, a change of sink or the destruction of
+     * the cursor ends it early. Only work done through this class is counted,
+     * not calls made directly on `CTSQueryCursor::RawCursor`. Matches are only
+     * counted by `CTSQueryCursor::NextMatch` and `CTSQueryCursor::CollectAll`.
+     *
+     * The cursor does not take ownership of the sink. Without a sink, the
+     * cursor does no extra work.
+     */
+    void SetMetricsSink(CTSMetricsSink* sink);
+
+    /**
+     * Get the cursor's current metrics sink, or nullptr.
+     */
+    CTSMetricsSink* MetricsSink() const { return m_metrics; }
+
 private:
+    void FlushStats() const;
+
+    CTSMetricsSink* m_metrics = nullptr;
+    mutable CTSQueryStats m_stats;
+    mutable bool m_stats_open = false;
+
     TSQueryMatch m_last_match{};
     uint32_t m_last_index = 0;
 
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "api.h"
+#include "CTSNode.h"
+#include "CTSQuery.h"
+#include "CTSQueryCursor.h"
+#include "CTSThreadPool.h"
+#include "CTSTree.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * One capture produced by a `CTSQueryExecutor`.
+ */
+struct CTSQueryExecCapture
+{
+    /**
+     * Index of the tree or byte range, in the list handed to the executor,
+     * that produced this capture.
+     */
+    size_t source;
+
+    /**
+     * Ordinal of the match within its source. Captures belonging to the same
+     * match are adjacent and share this value.
+     */
+    uint32_t match;
+
+    /**
+     * Index of the pattern that matched. See `CTSQuery::PatternCount`.
+     */
+    uint32_t pattern_index;
+
+    /**
+     * Id of the capture. See `CTSQuery::CaptureNameForId`.
+     */
+    uint32_t capture_index;
+
+    /**
+     * The captured node.
+     */
+    CTSNode node;
+};
+
+class CTSQueryExecutor
+{
+public:
+    CTSQueryExecutor(const CTSQueryExecutor&) = delete;
+    CTSQueryExecutor(const CTSQueryExecutor&&) = delete;
+    CTSQueryExecutor operator=(const CTSQueryExecutor&) = delete;
+    CTSQueryExecutor operator=(const CTSQueryExecutor&&) = delete;
+
+    /**
+     * Create an executor backed by thread_count worker threads (zero means one
+     * per hardware thread). Each worker owns one `CTSQueryCursor` that is reused
+     * for every tree or range it processes.
+     */
+    CTSQueryExecutor(unsigned thread_count = 0);
+
+    ~CTSQueryExecutor();
+
+    /**
+     * Get the number of worker threads.
+     */
+    unsigned ThreadCount() const { return m_pool.ThreadCount(); }
+
+    /**
+     * Set the match limit applied to every worker's cursor.
+     * See `CTSQueryCursor::SetMatchLimit`.
+     */
+    void SetMatchLimit(uint32_t limit) const;
+
+    /**
+     * Returns true if any cursor exceeded its match limit during the most recent
+     * execution. See `CTSQueryCursor::DidExceedMatchLimit`.
+     */
+    bool DidExceedMatchLimit() const { return m_exceeded_match_limit; }
+
+    /**
+     * Run the query over the root node of every tree in parallel.
+     *
+     * The query is only read, so a single `CTSQuery` is shared by all workers.
+     * Each tree is processed by exactly one worker; the caller must not use the
+     * trees on other threads until this method returns.
+     *
+     * The captures are returned grouped by tree in the order of `trees`, and
+     * within each tree in the order in which `CTSQueryCursor::NextMatch` reports
+     * them, so the result does not depend on thread scheduling. Null trees
+     * produce no captures.
+     */
+    std::vector<CTSQueryExecCapture> ExecTrees(const CTSQuery& query,
+                                               const std::vector<std::shared_ptr<CTSTree>>& trees);
+
+    /**
+     * Run the query over several byte ranges of one tree in parallel.
+     *
+     * The ranges must be ordered and must not overlap (only their byte offsets
+     * are used). Every worker runs on its own `CTSTree::Copy` of the tree, as
+     * tree-sitter requires; the returned nodes belong to the original tree.
+     *
+     * A match that spans several ranges is reported once, for the first range
+     * it intersects. Captures are ordered by range and then by match, as for
+     * `CTSQueryExecutor::ExecTrees`.
+     */
+    std::vector<CTSQueryExecCapture> ExecRanges(const CTSQuery& query,
+                                                const std::shared_ptr<CTSTree>& tree,
+                                                const std::vector<TSRange>& ranges);
+
+private:
+    void CollectMatches(CTSQueryCursor& cursor, size_t source,
+                        std::vector<CTSQueryExecCapture>& out,
+                        const std::vector<TSRange>* ranges);
+
+    static std::vector<CTSQueryExecCapture> Merge(std::vector<std::vector<CTSQueryExecCapture>>& parts);
+
+    CTSThreadPool m_pool;
+    std::vector<std::unique_ptr<CTSQueryCursor>> m_cursors;
+    std::atomic<bool> m_exceeded_match_limit{ false };
+};
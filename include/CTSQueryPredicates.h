@@ -0,0 +1,135 @@
+#pragma once
+
+#include "api.h"
+#include "CTSQuery.h"
+
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * A `#set!` directive of a query pattern, such as
+ * `(#set! injection.language "javascript")`.
+ */
+struct CTSQueryProperty
+{
+    std::string_view key;
+    std::string_view value;   // empty if the directive has no value
+    bool has_capture = false; // true if the directive names a capture
+    uint32_t capture_id = 0;
+};
+
+/**
+ * The text predicates of a query, compiled once and evaluated against the
+ * source text of each match.
+ *
+ * Tree-sitter only parses predicates into raw steps; what they mean is left to
+ * the caller. This class understands the standard ones:
+ *
+ *     (#eq? @capture "text")        (#not-eq? @capture "text")
+ *     (#eq? @capture @other)        (#not-eq? @capture @other)
+ *     (#match? @capture "regex")    (#not-match? @capture "regex")
+ *     (#any-of? @capture "a" "b")   (#not-any-of? @capture "a" "b")
+ *
+ * and the `#any-eq?`, `#any-not-eq?`, `#any-match?` and `#any-not-match?`
+ * variants, which are satisfied when any node of a quantified capture passes
+ * instead of all of them. `#set!` directives are collected as properties.
+ * Other predicates, such as `#is?`, are ignored.
+ *
+ * Strings are copied out of the query once, regular expressions are compiled
+ * once, and node text is compared as views into the source buffer, so string
+ * and capture comparisons do not allocate. Regular expressions use the
+ * ECMAScript grammar of std::regex, whose matching may allocate.
+ *
+ * Use it with `CTSQueryCursor::NextMatch(const CTSQueryPredicates&, std::string_view)`
+ * and friends to drop failing matches while iterating.
+ */
+class CTSQueryPredicates
+{
+public:
+    CTSQueryPredicates() = delete;
+    CTSQueryPredicates(const CTSQueryPredicates&) = delete;
+    CTSQueryPredicates(const CTSQueryPredicates&&) = delete;
+    CTSQueryPredicates operator=(const CTSQueryPredicates&) = delete;
+    CTSQueryPredicates operator=(const CTSQueryPredicates&&) = delete;
+
+    /**
+     * Compile the predicates of every pattern of the query. The query is not
+     * referenced afterwards.
+     */
+    CTSQueryPredicates(const CTSQuery& query);
+
+    ~CTSQueryPredicates() = default;
+
+    /**
+     * Returns false if a standard predicate was malformed: wrong arguments or
+     * an invalid regular expression. Such predicates never match.
+     */
+    bool IsValid() const { return m_error_pattern == UINT32_MAX; }
+
+    /**
+     * Get the index of the first pattern with a malformed predicate, or
+     * UINT32_MAX if there is none.
+     */
+    uint32_t ErrorPattern() const { return m_error_pattern; }
+
+    /**
+     * Returns true if the pattern has text predicates to evaluate.
+     */
+    bool HasPredicates(uint32_t pattern_index) const;
+
+    /**
+     * Check whether a match satisfies the predicates of its pattern. source is
+     * the text the tree was parsed from.
+     */
+    bool Satisfies(const TSQueryMatch& match, std::string_view source) const;
+
+    /**
+     * Get the `#set!` directives of a pattern.
+     */
+    const std::vector<CTSQueryProperty>& Properties(uint32_t pattern_index) const;
+
+    /**
+     * Find the value of a `#set!` directive of a pattern. Returns an empty
+     * view if the pattern has no such directive.
+     */
+    std::string_view Property(uint32_t pattern_index, std::string_view key) const;
+
+private:
+    enum class Op
+    {
+        Eq,
+        Match,
+        AnyOf
+    };
+
+    struct Predicate
+    {
+        Op op;
+        bool negate = false;
+        bool any = false;            // passes if any node passes, instead of all
+        uint32_t capture_id = 0;
+        bool rhs_is_capture = false; // Eq against another capture
+        uint32_t rhs = 0;            // string id, capture id, regex or set index
+    };
+
+    struct Pattern
+    {
+        std::vector<Predicate> predicates;
+        std::vector<CTSQueryProperty> properties;
+    };
+
+    bool Compile(uint32_t pattern_index, const std::vector<TSQueryPredicateStep>& steps);
+    bool Add(Pattern& pattern, Predicate predicate, const TSQueryPredicateStep* args, size_t nargs);
+    bool Test(const Predicate& predicate, std::string_view text) const;
+
+    static std::string_view NodeText(TSNode node, std::string_view source);
+
+    std::vector<std::string> m_strings;
+    std::vector<std::regex> m_regexes;
+    std::vector<std::unordered_set<std::string_view>> m_sets;
+    std::vector<Pattern> m_patterns;
+    uint32_t m_error_pattern = UINT32_MAX;
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "api.h"
+#include "CTSNode.h"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+class CTSQueryCursor;
+class CTSQueryPredicates;
+
+/**
+ * One capture as produced by `CTSQueryCursor::NextCapture`: the match it
+ * belongs to and its position in the match's captures.
+ *
+ * The match's captures array belongs to the cursor and is only valid until
+ * the cursor advances.
+ */
+struct CTSQueryCaptureResult
+{
+    TSQueryMatch match;
+    uint32_t capture_index;
+
+    /**
+     * Get the capture itself.
+     */
+    const TSQueryCapture& Capture() const { return match.captures[capture_index]; }
+
+    /**
+     * Get the captured node.
+     */
+    CTSNode Node() const { return match.captures[capture_index].node; }
+
+    /**
+     * Get the id of the capture. See `CTSQuery::CaptureNameForId`.
+     */
+    uint32_t CaptureId() const { return match.captures[capture_index].index; }
+};
+
+/**
+ * An input iterator that pulls matches from a `CTSQueryCursor` one at a time.
+ *
+ * Nothing is buffered: each increment runs the query just far enough to find
+ * the next match, so a loop that breaks early never pays for the rest of the
+ * tree. The dereferenced match is only valid until the next increment. All
+ * copies of an iterator share the cursor, so only one of them should be
+ * advanced. Iterators are usually obtained from `CTSQueryCursor::Matches`.
+ */
+class CTSQueryMatchIterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = TSQueryMatch;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const TSQueryMatch*;
+    using reference         = const TSQueryMatch&;
+
+    /**
+     * Creates an end iterator.
+     */
+    CTSQueryMatchIterator() = default;
+
+    /**
+     * Creates an iterator positioned on the next match of the cursor. If
+     * predicates is given, matches that do not satisfy them are skipped; see
+     * `CTSQueryCursor::NextMatch(const CTSQueryPredicates&, std::string_view)`.
+     */
+    CTSQueryMatchIterator(CTSQueryCursor* cursor, const CTSQueryPredicates* predicates = nullptr, std::string_view source = {});
+
+    const TSQueryMatch& operator*() const { return m_match; }
+    const TSQueryMatch* operator->() const { return &m_match; }
+
+    CTSQueryMatchIterator& operator++();
+
+    /**
+     * Two iterators compare equal when both have run out of matches.
+     */
+    bool operator==(const CTSQueryMatchIterator& other) const { return (m_cursor == nullptr) == (other.m_cursor == nullptr); }
+    bool operator!=(const CTSQueryMatchIterator& other) const { return !(*this == other); }
+
+private:
+    CTSQueryCursor* m_cursor = nullptr;
+    const CTSQueryPredicates* m_predicates = nullptr;
+    std::string_view m_source;
+    TSQueryMatch m_match{};
+};
+
+/**
+ * An input iterator that pulls captures from a `CTSQueryCursor` one at a time,
+ * in the order they appear in the document. See `CTSQueryMatchIterator` for
+ * the lifetime rules, which are the same.
+ */
+class CTSQueryCaptureIterator
+{
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = CTSQueryCaptureResult;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const CTSQueryCaptureResult*;
+    using reference         = const CTSQueryCaptureResult&;
+
+    /**
+     * Creates an end iterator.
+     */
+    CTSQueryCaptureIterator() = default;
+
+    /**
+     * Creates an iterator positioned on the next capture of the cursor. If
+     * predicates is given, captures of matches that do not satisfy them are
+     * skipped; see `CTSQueryCursor::NextCapture(const CTSQueryPredicates&, std::string_view)`.
+     */
+    CTSQueryCaptureIterator(CTSQueryCursor* cursor, const CTSQueryPredicates* predicates = nullptr, std::string_view source = {});
+
+    const CTSQueryCaptureResult& operator*() const { return m_capture; }
+    const CTSQueryCaptureResult* operator->() const { return &m_capture; }
+
+    CTSQueryCaptureIterator& operator++();
+
+    /**
+     * Two iterators compare equal when both have run out of captures.
+     */
+    bool operator==(const CTSQueryCaptureIterator& other) const { return (m_cursor == nullptr) == (other.m_cursor == nullptr); }
+    bool operator!=(const CTSQueryCaptureIterator& other) const { return !(*this == other); }
+
+private:
+    CTSQueryCursor* m_cursor = nullptr;
+    const CTSQueryPredicates* m_predicates = nullptr;
+    std::string_view m_source;
+    CTSQueryCaptureResult m_capture{};
+};
+
+/**
+ * A range over the remaining matches of a cursor, for use in range-based for
+ * loops:
+ *
+ *     for (const TSQueryMatch& match : cursor.Matches(query, tree->RootNode())) { ... }
+ *
+ * Iterating consumes the matches; calling begin() again resumes where the
+ * previous loop stopped.
+ */
+class CTSQueryMatchRange
+{
+public:
+    CTSQueryMatchRange(CTSQueryCursor* cursor, const CTSQueryPredicates* predicates = nullptr, std::string_view source = {}) :
+        m_cursor(cursor), m_predicates(predicates), m_source(source) {}
+
+    CTSQueryMatchIterator begin() const { return { m_cursor, m_predicates, m_source }; }
+    CTSQueryMatchIterator end() const { return {}; }
+
+private:
+    CTSQueryCursor* m_cursor;
+    const CTSQueryPredicates* m_predicates;
+    std::string_view m_source;
+};
+
+/**
+ * A range over the remaining captures of a cursor, in document order. See
+ * `CTSQueryMatchRange`.
+ */
+class CTSQueryCaptureRange
+{
+public:
+    CTSQueryCaptureRange(CTSQueryCursor* cursor, const CTSQueryPredicates* predicates = nullptr, std::string_view source = {}) :
+        m_cursor(cursor), m_predicates(predicates), m_source(source) {}
+
+    CTSQueryCaptureIterator begin() const { return { m_cursor, m_predicates, m_source }; }
+    CTSQueryCaptureIterator end() const { return {}; }
+
+private:
+    CTSQueryCursor* m_cursor;
+    const CTSQueryPredicates* m_predicates;
+    std::string_view m_source;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "api.h"
+#include "CTSNode.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Flat, reusable storage for the results of running a query.
+ *
+ * `CTSQueryCursor::CollectAll` and `CTSQueryCursor::CollectAllCaptures` drain
+ * a cursor into a CTSQueryResults object. Every capture becomes one row, and
+ * each property of the rows lives in its own contiguous column. Collecting
+ * clears the previous rows but keeps the capacity of the columns, so running a
+ * query over many trees with the same results object stops allocating once
+ * the largest result set has been seen.
+ *
+ * Rows collected with `CTSQueryCursor::CollectAll` are grouped by match, and
+ * the match columns tell where each match's rows begin. Rows collected with
+ * `CTSQueryCursor::CollectAllCaptures` are in document order, and the match
+ * columns are left empty.
+ */
+class CTSQueryResults
+{
+public:
+    CTSQueryResults(const CTSQueryResults&) = delete;
+    CTSQueryResults(const CTSQueryResults&&) = delete;
+    CTSQueryResults operator=(const CTSQueryResults&) = delete;
+    CTSQueryResults operator=(const CTSQueryResults&&) = delete;
+
+    CTSQueryResults() = default;
+    ~CTSQueryResults() = default;
+
+    /**
+     * Remove every row and match, keeping the allocated capacity.
+     */
+    void Clear();
+
+    /**
+     * Preallocate room for the given number of captures and matches.
+     */
+    void Reserve(size_t captures, size_t matches);
+
+    /**
+     * Get the number of capture rows.
+     */
+    size_t CaptureCount() const { return m_nodes.size(); }
+
+    /**
+     * Get the number of matches, which is zero for results collected capture
+     * by capture.
+     */
+    size_t MatchCount() const { return m_match_patterns.size(); }
+
+    /**
+     * Get the number of capture rows there is room for without allocating.
+     */
+    size_t CaptureCapacity() const { return m_nodes.capacity(); }
+
+    /**
+     * Capture columns. Each pointer addresses CaptureCount() consecutive entries.
+     *
+     * MatchIds holds the id of the match a capture belongs to (see
+     * `CTSQueryCursor::RemoveMatch`), PatternIndices the index of the pattern
+     * that matched and CaptureIds the id of the capture (see
+     * `CTSQuery::CaptureNameForId`).
+     */
+    const uint32_t* MatchIds() const { return m_match_ids.data(); }
+    const uint16_t* PatternIndices() const { return m_pattern_indices.data(); }
+    const uint32_t* CaptureIds() const { return m_capture_ids.data(); }
+    const TSNode* Nodes() const { return m_nodes.data(); }
+    const uint32_t* StartBytes() const { return m_start_bytes.data(); }
+    const uint32_t* EndBytes() const { return m_end_bytes.data(); }
+
+    /**
+     * Per-row accessors.
+     */
+    uint32_t MatchId(size_t row) const { return m_match_ids[row]; }
+    uint16_t PatternIndex(size_t row) const { return m_pattern_indices[row]; }
+    uint32_t CaptureId(size_t row) const { return m_capture_ids[row]; }
+    CTSNode Node(size_t row) const { return m_nodes[row]; }
+    uint32_t StartByte(size_t row) const { return m_start_bytes[row]; }
+    uint32_t EndByte(size_t row) const { return m_end_bytes[row]; }
+
+    /**
+     * Match columns. MatchPatternIndices addresses MatchCount() entries.
+     * MatchFirstCaptures addresses MatchCount() + 1 entries: the rows of match
+     * m are [MatchFirstCaptures()[m], MatchFirstCaptures()[m + 1]).
+     */
+    const uint16_t* MatchPatternIndices() const { return m_match_patterns.data(); }
+    const uint32_t* MatchFirstCaptures() const { return m_match_starts.data(); }
+
+    /**
+     * Get the first row and the number of rows of a match.
+     */
+    uint32_t MatchFirstCapture(size_t match) const { return m_match_starts[match]; }
+    uint32_t MatchCaptureCount(size_t match) const { return m_match_starts[match + 1] - m_match_starts[match]; }
+
+private:
+    friend class CTSQueryCursor;
+
+    void AppendCapture(const TSQueryMatch& match, uint32_t capture_index);
+    void AppendMatch(const TSQueryMatch& match);
+
+    std::vector<uint32_t> m_match_ids;
+    std::vector<uint16_t> m_pattern_indices;
+    std::vector<uint32_t> m_capture_ids;
+    std::vector<TSNode> m_nodes;
+    std::vector<uint32_t> m_start_bytes;
+    std::vector<uint32_t> m_end_bytes;
+
+    std::vector<uint16_t> m_match_patterns;
+    std::vector<uint32_t> m_match_starts{ 0 }; // always MatchCount() + 1 entries
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "api.h"
+#include "CTSQuery.h"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+/**
+ * Where a pattern of a `CTSQuerySet` came from.
+ */
+struct CTSQuerySetOrigin
+{
+    /**
+     * Index of the source, in the list given to the query set.
+     */
+    uint32_t source = 0;
+
+    /**
+     * Index of the pattern within that source, as `CTSQuery` would number it
+     * if the source were compiled on its own.
+     */
+    uint32_t pattern_index = 0;
+};
+
+/**
+ * Several query sources compiled into one combined query.
+ *
+ * Executing N queries separately walks the tree N times. A query set joins
+ * the sources into a single `CTSQuery`, so one `CTSQueryCursor` pass over the
+ * tree finds the matches of all of them:
+ *
+ *     CTSQuerySet set(language, { rule_a, rule_b, rule_c });
+ *     cursor.Exec(set.Query(), tree->RootNode());
+ *     while (cursor.NextMatch())
+ *     {
+ *         const CTSQuerySetOrigin origin = set.PatternOrigin(cursor.GetMatchResult().pattern_index);
+ *         ...
+ *     }
+ *
+ * Pattern indices of the combined query are mapped back to the source they
+ * came from and to their index within it. Capture ids are shared by name
+ * across the combined query; `CTSQuerySet::LocalCaptureId` maps them back to
+ * the ids the source would use on its own. To build that table, and to tell
+ * which source is at fault when compilation fails, each source is also
+ * compiled separately, once, when the set is created.
+ */
+class CTSQuerySet
+{
+public:
+    static constexpr uint32_t NoCapture = UINT32_MAX;
+
+    CTSQuerySet() = delete;
+    CTSQuerySet(const CTSQuerySet&) = delete;
+    CTSQuerySet(const CTSQuerySet&&) = delete;
+    CTSQuerySet operator=(const CTSQuerySet&) = delete;
+    CTSQuerySet operator=(const CTSQuerySet&&) = delete;
+
+    /**
+     * Compile the sources into one query for the given language.
+     */
+    CTSQuerySet(const TSLanguage* language, const std::vector<std::string_view>& sources);
+
+    ~CTSQuerySet() = default;
+
+    /**
+     * Returns true if every source compiled.
+     */
+    bool IsValid() const { return m_error_source == UINT32_MAX; }
+
+    /**
+     * Get the index of the first source that failed to compile, or
+     * UINT32_MAX. The error code and offset within that source are available
+     * from `SourceQuery(ErrorSource())`.
+     */
+    uint32_t ErrorSource() const { return m_error_source; }
+
+    /**
+     * Get the combined query. Only usable when the set is valid.
+     */
+    const CTSQuery& Query() const { return *m_query; }
+
+    /**
+     * Get the number of sources.
+     */
+    uint32_t SourceCount() const { return static_cast<uint32_t>(m_sources.size()); }
+
+    /**
+     * Get the query compiled from one source on its own.
+     */
+    const CTSQuery& SourceQuery(uint32_t source) const { return *m_sources[source].query; }
+
+    /**
+     * Map a pattern index of the combined query back to its source.
+     */
+    CTSQuerySetOrigin PatternOrigin(uint32_t pattern_index) const;
+
+    /**
+     * Get the index of the first combined pattern that came from the source.
+     * The source's patterns are [FirstPattern(source), FirstPattern(source + 1)).
+     */
+    uint32_t FirstPattern(uint32_t source) const { return m_first_patterns[source]; }
+
+    /**
+     * Map a capture id of the combined query to the id the source's own query
+     * uses for the same capture name, or `CTSQuerySet::NoCapture` if the
+     * source has no capture of that name.
+     */
+    uint32_t LocalCaptureId(uint32_t source, uint32_t capture_id) const;
+
+private:
+    struct Source
+    {
+        std::unique_ptr<CTSQuery> query;
+        std::vector<uint32_t> local_capture_ids; // indexed by combined capture id
+    };
+
+    std::unique_ptr<CTSQuery> m_query;
+    std::vector<Source> m_sources;
+    std::vector<uint32_t> m_first_patterns;  // SourceCount() + 1 entries
+    std::vector<uint32_t> m_pattern_sources; // indexed by combined pattern index
+    uint32_t m_error_source = UINT32_MAX;
+};
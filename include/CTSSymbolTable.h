@@ -0,0 +1,170 @@
+#pragma once
+
+#include "api.h"
+#include "CTSNode.h"
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * Hash a node type or field name at compile time.
+ *
+ * The hash is 64-bit FNV-1a, which is also what `CTSLanguage::SymbolHash`
+ * returns for each symbol of a language. Together they allow dispatching on
+ * node kinds with an integer switch instead of string comparisons:
+ *
+ *     switch (lang->SymbolHash(node.Symbol()))
+ *     {
+ *     case CTSNameHash("function_definition"): ...
+ *     case CTSNameHash("identifier"): ...
+ *     }
+ */
+constexpr uint64_t CTSNameHash(std::string_view name)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (const char c : name)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * The symbol of ERROR nodes. It is a built-in symbol at the very top of the
+ * symbol range, so the tables below keep it in a slot of its own rather than
+ * sizing their storage to reach it.
+ */
+constexpr TSSymbol CTSErrorSymbol = static_cast<TSSymbol>(-1);
+
+/**
+ * A dense set of symbols, stored as one bit per symbol id.
+ *
+ * Membership tests are a shift and a mask, which makes this suitable for
+ * filtering nodes in the hot loop of a tree walk. Build one with
+ * `CTSLanguage::ResolveSymbols`.
+ */
+class CTSSymbolSet
+{
+public:
+    CTSSymbolSet() = default;
+
+    /**
+     * Add a symbol to the set.
+     */
+    void Insert(TSSymbol symbol)
+    {
+        if (symbol == CTSErrorSymbol)
+        {
+            m_has_error = true;
+            return;
+        }
+
+        const size_t word = symbol / 64;
+
+        if (word >= m_bits.size())
+        {
+            m_bits.resize(word + 1, 0);
+        }
+        m_bits[word] |= (uint64_t(1) << (symbol % 64));
+    }
+
+    /**
+     * Check whether the set contains the given symbol.
+     */
+    bool Contains(TSSymbol symbol) const
+    {
+        const size_t word = symbol / 64;
+
+        if (word < m_bits.size())
+        {
+            return (m_bits[word] >> (symbol % 64)) & 1;
+        }
+        return (symbol == CTSErrorSymbol) && m_has_error;
+    }
+
+    /**
+     * Check whether the set contains the node's symbol.
+     */
+    bool Contains(const CTSNode& node) const { return Contains(node.Symbol()); }
+
+    /**
+     * Returns true if no symbol has been added.
+     */
+    bool Empty() const
+    {
+        if (m_has_error)
+        {
+            return false;
+        }
+
+        for (const uint64_t word : m_bits)
+        {
+            if (word)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<uint64_t> m_bits;
+    bool m_has_error = false;
+};
+
+/**
+ * A jump table from symbol ids to values, e.g. handler indices or enum tags.
+ *
+ * Lookups are a bounds check and an array index; symbols that were never
+ * assigned yield the default value given at construction. Build one with
+ * `CTSLanguage::MakeSymbolMap`.
+ */
+template <typename T>
+class CTSSymbolMap
+{
+public:
+    CTSSymbolMap(T default_value = T()) : m_default(default_value), m_error(default_value) {}
+
+    /**
+     * Assign a value to a symbol.
+     */
+    void Set(TSSymbol symbol, T value)
+    {
+        if (symbol == CTSErrorSymbol)
+        {
+            m_error = value;
+            return;
+        }
+
+        if (symbol >= m_values.size())
+        {
+            m_values.resize(static_cast<size_t>(symbol) + 1, m_default);
+        }
+        m_values[symbol] = value;
+    }
+
+    /**
+     * Get the value assigned to the symbol, or the default value.
+     */
+    const T& operator[](TSSymbol symbol) const
+    {
+        if (symbol < m_values.size())
+        {
+            return m_values[symbol];
+        }
+        return (symbol == CTSErrorSymbol) ? m_error : m_default;
+    }
+
+    /**
+     * Get the value assigned to the node's symbol, or the default value.
+     */
+    const T& operator[](const CTSNode& node) const { return (*this)[node.Symbol()]; }
+
+private:
+    std::vector<T> m_values;
+    T m_default;
+    T m_error;
+};
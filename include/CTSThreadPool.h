@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads that execute indexed loops with work stealing.
+ *
+ * Each call to `CTSThreadPool::ParallelFor` splits the index space into one
+ * contiguous range per worker. A worker consumes its own range from the front;
+ * once it runs dry it steals the back half of another worker's range, so uneven
+ * item costs (e.g. files of very different sizes) still keep every thread busy.
+ *
+ * Every task is told which worker runs it. Worker numbers are stable for the
+ * lifetime of the pool, which lets callers keep per-worker state such as a
+ * parser or a query cursor in a plain vector indexed by worker number.
+ */
+class CTSThreadPool
+{
+public:
+    using Task = std::function<void(size_t index, unsigned worker)>;
+
+    CTSThreadPool(const CTSThreadPool&) = delete;
+    CTSThreadPool(const CTSThreadPool&&) = delete;
+    CTSThreadPool operator=(const CTSThreadPool&) = delete;
+    CTSThreadPool operator=(const CTSThreadPool&&) = delete;
+
+    /**
+     * Start the worker threads. A thread_count of zero uses one thread per
+     * hardware thread.
+     */
+    CTSThreadPool(unsigned thread_count = 0);
+
+    /**
+     * Stop and join the worker threads.
+     */
+    ~CTSThreadPool();
+
+    /**
+     * Get the number of worker threads.
+     */
+    unsigned ThreadCount() const { return static_cast<unsigned>(m_threads.size()); }
+
+    /**
+     * Call task(index, worker) once for every index in [0, count) and wait until
+     * all calls have returned.
+     *
+     * Calls run concurrently on the worker threads, in no particular order.
+     * Only one loop runs at a time; concurrent callers are serialized. The task
+     * must not throw and must not call ParallelFor on the same pool.
+     */
+    void ParallelFor(size_t count, const Task& task);
+
+private:
+    struct WorkRange
+    {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void WorkerMain(unsigned worker);
+    bool TakeIndex(unsigned worker, size_t* index);
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::unique_ptr<WorkRange>> m_ranges;
+
+    std::mutex m_submit_mutex;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Task* m_task = nullptr;
+    uint64_t m_generation = 0;
+    unsigned m_busy = 0;
+    bool m_stopping = false;
+};
@@ -1,13 +1,50 @@
 #pragma once
 
 #include "api.h"
+#include "CTSMemory.h"
+#include "CTSMetrics.h"
 #include "CTSNode.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 
 class CTSTree;
 
+/**
+ * Memory usage of a syntax tree, as reported by `CTSTree::MemoryUsage`.
+ */
+struct CTSTreeMemoryUsage
+{
+    /**
+     * Number of nodes reachable through the node API.
+     */
+    uint32_t node_count = 0;
+
+    /**
+     * Number of those nodes that are also part of the tree passed for comparison.
+     */
+    uint32_t shared_node_count = 0;
+
+    /**
+     * Estimate of the memory held by the nodes, node_count times
+     * `CTSTree::EstimatedBytesPerNode`.
+     */
+    size_t estimated_bytes = 0;
+
+    /**
+     * Estimate of the memory held by nodes that are not shared with the
+     * comparison tree, i.e. what deleting this tree alone would release.
+     */
+    size_t estimated_unique_bytes = 0;
+
+    /**
+     * Bytes tree-sitter allocated while producing this tree that are still
+     * live. Only available when `CTSMemory` is installed; zero otherwise.
+     */
+    size_t tracked_bytes = 0;
+};
+
 class CTSTreeCursor : public TSTreeCursor
 {
 public:
@@ -43,6 +80,14 @@ public:
      */
     std::string CurrentFieldName(bool* was_found) const;
 
+    /**
+     * Get the field name of the tree cursor's current node without allocating.
+     *
+     * Behaves like `CTSTreeCursor::CurrentFieldName`, but returns a view into
+     * static storage owned by the language.
+     */
+    std::string_view CurrentFieldNameView(bool* was_found = nullptr) const;
+
     /**
      * Get the field id of the tree cursor's current node.
      *
@@ -96,6 +141,7 @@ public:
     CTSTreeCursor Copy() const;
 
     friend class CTSTree;
+    friend class CTSTreeWalkIterator;
 
 private:
     CTSTreeCursor(CTSNode node);
@@ -156,6 +202,14 @@ public:
      */
     void Edit(const TSInputEdit* edit) const;
 
+    /**
+     * Apply a batch of edits to the syntax tree, in order.
+     *
+     * Each edit must be expressed in terms of the document as it stands after
+     * all of the preceding edits in the batch have been applied.
+     */
+    void Edit(const std::vector<TSInputEdit>& edits) const;
+
     /**
      * Compare an old edited syntax tree to a new syntax tree representing the same
      * document, returning an array of ranges whose syntactic structure has changed.
@@ -168,6 +222,32 @@ public:
      */
     std::vector<TSRange> GetChangedRanges(const std::shared_ptr<CTSTree>& new_tree) const;
 
+    /**
+     * Approximate heap footprint of one node, used by `CTSTree::MemoryUsage`.
+     */
+    static constexpr size_t EstimatedBytesPerNode = 80;
+
+    /**
+     * Report how much memory the tree retains.
+     *
+     * Trees produced by copying or by incremental reparsing share most of their
+     * nodes. When other is given, nodes shared with it are counted separately,
+     * so that estimated_unique_bytes tells how much memory this tree holds on
+     * its own. This walks the whole tree (and other), so it is not free.
+     *
+     * The tracked_bytes figure is exact but is only collected once `CTSMemory`
+     * is installed. It covers the allocations made while this tree was parsed
+     * or copied; nodes reused from an older tree stay charged to that tree.
+     */
+    CTSTreeMemoryUsage MemoryUsage(const CTSTree* other = nullptr) const;
+
+    /**
+     * Get the statistics recorded while this tree was parsed, or nullptr if the
+     * parser had no metrics sink installed (see `CTSParser::SetMetricsSink`).
+     * Copies of the tree share the statistics of the original.
+     */
+    const CTSParseStats* ParseStats() const { return m_parse_stats.get(); }
+
     /**
      * Write a DOT graph describing the syntax tree to the given file.
      */
@@ -197,4 +277,10 @@ public:
 
 private:
     TSTree* m_tree = nullptr;
+    CTSMemoryAccount* m_account = nullptr;
+
+    // Arenas that may hold nodes of this tree; see `CTSArena`.
+    std::vector<std::shared_ptr<CTSArena>> m_arenas;
+
+    std::shared_ptr<const CTSParseStats> m_parse_stats;
 };
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "api.h"
+#include "CTSNode.h"
+#include "CTSTree.h"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string_view>
+
+/**
+ * What a visitor's Enter callback asks the walker to do next.
+ */
+enum class CTSVisitAction
+{
+    Continue,     // descend into the node's children
+    SkipChildren, // do not visit the node's children; Leave is still called
+    Stop          // abandon the walk immediately
+};
+
+/**
+ * An input iterator that walks a subtree with a `CTSTreeCursor`.
+ *
+ * Moving a tree cursor is much cheaper than navigating with `CTSNode::Child`
+ * and friends, which recompute node positions from the parent on every call.
+ *
+ * Copies of an iterator share the same cursor, so only one of them should be
+ * advanced. Iterators are usually obtained from a `CTSTreeWalkRange`.
+ */
+class CTSTreeWalkIterator
+{
+public:
+    enum class Order
+    {
+        PreOrder,  // parents before their children
+        PostOrder  // children before their parents
+    };
+
+    using iterator_category = std::input_iterator_tag;
+    using value_type        = CTSNode;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const CTSNode*;
+    using reference         = CTSNode;
+
+    /**
+     * Creates an end iterator.
+     */
+    CTSTreeWalkIterator() = default;
+
+    /**
+     * Creates an iterator positioned on the first node of the walk of root's
+     * subtree. If named_only is true, anonymous nodes are skipped.
+     */
+    CTSTreeWalkIterator(CTSNode root, Order order, bool named_only);
+
+    CTSNode operator*() const { return m_cursor->CurrentNode(); }
+
+    CTSTreeWalkIterator& operator++();
+
+    /**
+     * Two iterators compare equal when both have reached the end of their walk.
+     */
+    bool operator==(const CTSTreeWalkIterator& other) const { return AtEnd() == other.AtEnd(); }
+    bool operator!=(const CTSTreeWalkIterator& other) const { return !(*this == other); }
+
+    /**
+     * Get the depth of the current node below the root of the walk, which is at depth zero.
+     */
+    uint32_t Depth() const { return m_depth; }
+
+    /**
+     * Get the field id of the current node within its parent, or zero.
+     */
+    TSFieldId FieldId() const { return m_cursor->CurrentFieldId(); }
+
+    /**
+     * Get the field name of the current node within its parent, or an empty view.
+     */
+    std::string_view FieldName() const { return m_cursor->CurrentFieldNameView(); }
+
+    /**
+     * In a pre-order walk, do not descend into the current node's children on
+     * the next increment. Has no effect on post-order walks.
+     */
+    void SkipChildren() { m_skip_children = true; }
+
+private:
+    bool AtEnd() const { return !m_cursor; }
+    bool Step();
+    void DescendToFirstLeaf();
+    bool Accept() const;
+
+    std::shared_ptr<CTSTreeCursor> m_cursor;
+    Order m_order = Order::PreOrder;
+    uint32_t m_depth = 0;
+    bool m_named_only = false;
+    bool m_skip_children = false;
+};
+
+/**
+ * A range over the nodes of a subtree, for use in range-based for loops:
+ *
+ *     for (CTSNode node : CTSTreeWalker::NamedPreOrder(tree->RootNode())) { ... }
+ */
+class CTSTreeWalkRange
+{
+public:
+    CTSTreeWalkRange(CTSNode root, CTSTreeWalkIterator::Order order, bool named_only) :
+        m_root(root), m_order(order), m_named_only(named_only) {}
+
+    CTSTreeWalkIterator begin() const { return { m_root, m_order, m_named_only }; }
+    CTSTreeWalkIterator end() const { return {}; }
+
+private:
+    CTSNode m_root;
+    CTSTreeWalkIterator::Order m_order;
+    bool m_named_only;
+};
+
+class CTSTreeWalker
+{
+public:
+    /**
+     * Get a range that visits every node in root's subtree, parents first.
+     */
+    static CTSTreeWalkRange PreOrder(CTSNode root) { return { root, CTSTreeWalkIterator::Order::PreOrder, false }; }
+
+    /**
+     * Get a range that visits every node in root's subtree, children first.
+     */
+    static CTSTreeWalkRange PostOrder(CTSNode root) { return { root, CTSTreeWalkIterator::Order::PostOrder, false }; }
+
+    /**
+     * Get a range that visits the *named* nodes in root's subtree, parents first.
+     */
+    static CTSTreeWalkRange NamedPreOrder(CTSNode root) { return { root, CTSTreeWalkIterator::Order::PreOrder, true }; }
+
+    /**
+     * Get a range that visits the *named* nodes in root's subtree, children first.
+     */
+    static CTSTreeWalkRange NamedPostOrder(CTSNode root) { return { root, CTSTreeWalkIterator::Order::PostOrder, true }; }
+
+    /**
+     * Walk root's subtree depth-first with a tree cursor, calling the visitor
+     * on the way down and on the way back up.
+     *
+     * The visitor must provide these two members:
+     *
+     *     CTSVisitAction Enter(const CTSTreeCursor& cursor, uint32_t depth);
+     *     void Leave(const CTSTreeCursor& cursor, uint32_t depth);
+     *
+     * The cursor is positioned on the node being visited, so the callbacks can
+     * read its node, field id and field name. Depth is zero for root. Every
+     * Enter is matched by a Leave unless the walk is stopped.
+     *
+     * Returns false if the visitor stopped the walk, true otherwise.
+     */
+    template <typename Visitor>
+    static bool Walk(CTSNode root, Visitor& visitor)
+    {
+        CTSTreeCursor cursor = CTSTree::GetCursorAtNode(root);
+        uint32_t      depth  = 0;
+
+        for (;;)
+        {
+            const CTSVisitAction action = visitor.Enter(cursor, depth);
+
+            if (action == CTSVisitAction::Stop)
+            {
+                return false;
+            }
+
+            if ((action == CTSVisitAction::Continue) && cursor.GotoFirstChild())
+            {
+                depth++;
+                continue;
+            }
+
+            // Leave the current node, then move to its next sibling or keep
+            // climbing until an ancestor has one.
+            for (;;)
+            {
+                visitor.Leave(cursor, depth);
+
+                if (depth == 0)
+                {
+                    return true;
+                }
+
+                if (cursor.GotoNextSibling())
+                {
+                    break;
+                }
+
+                cursor.GotoParent();
+                depth--;
+            }
+        }
+    }
+
+    /**
+     * Walk root's subtree with a pair of callables instead of a visitor object.
+     * See the other entry for Walk() for details.
+     */
+    template <typename EnterFn, typename LeaveFn>
+    static bool Walk(CTSNode root, EnterFn&& enter, LeaveFn&& leave)
+    {
+        struct Adapter
+        {
+            EnterFn& enter;
+            LeaveFn& leave;
+
+            CTSVisitAction Enter(const CTSTreeCursor& cursor, uint32_t depth) { return enter(cursor, depth); }
+            void Leave(const CTSTreeCursor& cursor, uint32_t depth) { leave(cursor, depth); }
+        } adapter{ enter, leave };
+
+        return Walk(root, adapter);
+    }
+};
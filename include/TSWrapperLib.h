@@ -1,8 +1,32 @@
 
 
+#include "CTSAsyncParseService.h"
+#include "CTSBatchParser.h"
+#include "CTSCancellationToken.h"
+#include "CTSContentHash.h"
+#include "CTSDocumentStore.h"
+#include "CTSFlatTree.h"
+#include "CTSIncrementalQuery.h"
+#include "CTSInjectionEngine.h"
+#include "CTSInputSource.h"
 #include "CTSLanguage.h"
+#include "CTSMappedFile.h"
+#include "CTSMemory.h"
+#include "CTSMetrics.h"
 #include "CTSNode.h"
 #include "CTSParser.h"
+#include "CTSParseCache.h"
+#include "CTSParseSession.h"
+#include "CTSParseTask.h"
 #include "CTSQuery.h"
+#include "CTSQueryCache.h"
 #include "CTSQueryCursor.h"
+#include "CTSQueryExecutor.h"
+#include "CTSQueryPredicates.h"
+#include "CTSQueryRange.h"
+#include "CTSQueryResults.h"
+#include "CTSQuerySet.h"
+#include "CTSSymbolTable.h"
+#include "CTSThreadPool.h"
 #include "CTSTree.h"
+#include "CTSTreeWalker.h"
@@ -0,0 +1,491 @@
+#include "CTSAsyncParseService.h"
+#include "CTSParseTask.h"
+
+#include <algorithm>
+
+CTSAsyncParseService::CTSAsyncParseService(const TSLanguage *language, CTSAsyncParseOptions options) :
+    m_options(options)
+{
+    unsigned thread_count = m_options.thread_count;
+
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_options.queue_capacity = std::max<size_t>(1, m_options.queue_capacity);
+
+    for (unsigned idx = 0; idx < thread_count; idx++)
+    {
+        m_parsers.push_back(std::make_unique<CTSParser>(language));
+        m_parsers.back()->SetMetricsSink(m_options.metrics);
+        m_set_lang_result = m_set_lang_result && m_parsers.back()->LanguageSetResult();
+    }
+
+    for (unsigned idx = 0; idx < thread_count; idx++)
+    {
+        m_threads.emplace_back(&CTSAsyncParseService::WorkerMain, this, idx);
+    }
+}
+
+CTSAsyncParseService::~CTSAsyncParseService()
+{
+    std::vector<std::unique_ptr<Job> > abandoned;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+
+        for (auto& entry : m_documents)
+        {
+            entry.second->token.Cancel();
+
+            if (entry.second->pending)
+            {
+                abandoned.push_back(std::move(entry.second->pending));
+            }
+        }
+        m_queue.clear();
+    }
+    m_wake.notify_all();
+    m_space.notify_all();
+
+    for (auto& job : abandoned)
+    {
+        const auto result = Outcome(*job, CTSAsyncParseStatus::Cancelled);
+        Resolve(std::move(job), result);
+    }
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+std::future<CTSAsyncParseResult>CTSAsyncParseService::Submit(CTSAsyncParseRequest request)
+{
+    auto job = std::make_unique<Job>();
+
+    job->request = std::move(request);
+
+    auto retval = job->promise.get_future();
+
+    Enqueue(std::move(job), true);
+    return retval;
+}
+
+void CTSAsyncParseService::Submit(CTSAsyncParseRequest request, Callback callback)
+{
+    auto job = std::make_unique<Job>();
+
+    job->request  = std::move(request);
+    job->callback = std::move(callback);
+    Enqueue(std::move(job), true);
+}
+
+bool CTSAsyncParseService::TrySubmit(CTSAsyncParseRequest request, std::future<CTSAsyncParseResult> *future)
+{
+    auto job = std::make_unique<Job>();
+
+    job->request = std::move(request);
+
+    auto retval = job->promise.get_future();
+
+    if (!Enqueue(std::move(job), false))
+    {
+        return false;
+    }
+
+    if (future)
+    {
+        *future = std::move(retval);
+    }
+    return true;
+}
+
+bool CTSAsyncParseService::Enqueue(std::unique_ptr<Job> job, bool wait)
+{
+    job->incremental = !job->request.edits.empty();
+
+    std::unique_ptr<Job> superseded;
+    std::unique_ptr<Job> cancelled;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // Replacing a waiting request never grows the queue, so only new
+        // entries have to wait for room.
+        auto has_room = [&]()
+                        {
+                            if (m_stopping || (m_queue.size() < m_options.queue_capacity))
+                            {
+                                return true;
+                            }
+
+                            const auto found = m_documents.find(job->request.document_id);
+                            return (found != m_documents.end()) && found->second->pending;
+                        };
+
+        if (!has_room())
+        {
+            if (!wait)
+            {
+                return false;
+            }
+            m_space.wait(lock, has_room);
+        }
+
+        if (m_stopping)
+        {
+            cancelled = std::move(job);
+            m_running++;
+        }
+        else
+        {
+            auto& document = m_documents[job->request.document_id];
+
+            if (!document)
+            {
+                document     = std::make_unique<Document>();
+                document->id = job->request.document_id;
+            }
+
+            document->closed = false;
+
+            if (document->pending)
+            {
+                // Fold the waiting version into this one: its edits come
+                // first, and a wholesale replacement anywhere in the chain
+                // makes the result one too.
+                Job& older = *document->pending;
+
+                if (job->incremental && older.incremental)
+                {
+                    job->request.edits.insert(job->request.edits.begin(),
+                                              older.request.edits.begin(),
+                                              older.request.edits.end());
+                }
+                else
+                {
+                    job->incremental = false;
+                    job->request.edits.clear();
+                }
+                superseded        = std::move(document->pending);
+                document->pending = std::move(job);
+                m_running++;
+            }
+            else
+            {
+                document->pending = std::move(job);
+                m_queue.push_back(document.get());
+            }
+
+            if (document->in_flight && m_options.cancel_superseded)
+            {
+                document->token.Cancel();
+            }
+        }
+    }
+
+    m_wake.notify_one();
+
+    if (superseded)
+    {
+        const auto result = Outcome(*superseded, CTSAsyncParseStatus::Superseded);
+        Resolve(std::move(superseded), result);
+        Resolved();
+    }
+
+    if (cancelled)
+    {
+        const auto result = Outcome(*cancelled, CTSAsyncParseStatus::Cancelled);
+        Resolve(std::move(cancelled), result);
+        Resolved();
+    }
+    return true;
+}
+
+CTSAsyncParseService::Document * CTSAsyncParseService::NextDocument()
+{
+    // Versions of one document are parsed one at a time, so skip documents
+    // whose previous version is still being parsed.
+    for (auto it = m_queue.begin(); it != m_queue.end(); ++it)
+    {
+        if (!(*it)->in_flight)
+        {
+            Document *retval = *it;
+            m_queue.erase(it);
+            return retval;
+        }
+    }
+    return nullptr;
+}
+
+void CTSAsyncParseService::WorkerMain(unsigned worker)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        Document *document = nullptr;
+
+        m_wake.wait(lock, [&]()
+                    {
+                        return m_stopping || ((document = NextDocument()) != nullptr);
+                    });
+
+        if (m_stopping)
+        {
+            return;
+        }
+
+        m_space.notify_one();
+        RunJob(document, std::move(document->pending), worker, lock);
+    }
+}
+
+void CTSAsyncParseService::RunJob(Document                   *document,
+                                  std::unique_ptr<Job>         job,
+                                  unsigned                     worker,
+                                  std::unique_lock<std::mutex>& lock)
+{
+    // Take what the parse needs while holding the lock.
+    const bool use_base = job->incremental && document->carry_valid && document->tree;
+
+    std::vector<TSInputEdit> edits;
+    std::shared_ptr<CTSTree> base;
+
+    if (use_base)
+    {
+        edits = document->carry_edits;
+        edits.insert(edits.end(), job->request.edits.begin(), job->request.edits.end());
+        base = document->tree;
+    }
+    document->carry_edits.clear();
+
+    document->in_flight = true;
+    document->token     = (m_options.parse_timeout.count() > 0) ?
+                          CTSCancellationToken::After(m_options.parse_timeout) : CTSCancellationToken();
+
+    const CTSCancellationToken token      = document->token;
+    const uint64_t             generation = document->generation;
+
+    m_running++;
+    lock.unlock();
+
+    // Published trees are never edited; the edits go to a cheap copy.
+    std::shared_ptr<CTSTree> old_tree;
+
+    if (base)
+    {
+        old_tree = base->Copy(base.get());
+        old_tree->Edit(edits);
+    }
+
+    static const std::string empty;
+    const std::string& source = job->request.source ? *job->request.source : empty;
+
+    CTSParseTask task(*m_parsers[worker], source, old_tree, token);
+
+    const CTSParseStatus status = task.Run();
+    CTSAsyncParseResult  result = Outcome(*job, CTSAsyncParseStatus::Failed);
+
+    if (status == CTSParseStatus::Completed)
+    {
+        result.status = CTSAsyncParseStatus::Completed;
+        result.tree   = task.Tree();
+
+        if (old_tree)
+        {
+            result.changed_ranges = old_tree->GetChangedRanges(result.tree);
+        }
+        else
+        {
+            const CTSNode root = result.tree->RootNode();
+            result.changed_ranges.push_back({ root.StartPoint(), root.EndPoint(),
+                                              root.StartByte(), root.EndByte() });
+        }
+    }
+    else if (status == CTSParseStatus::Cancelled)
+    {
+        result.status = CTSAsyncParseStatus::Cancelled;
+    }
+    else if (status == CTSParseStatus::DeadlineExceeded)
+    {
+        result.status = CTSAsyncParseStatus::DeadlineExceeded;
+    }
+
+    lock.lock();
+    document->in_flight = false;
+
+    if (document->generation != generation)
+    {
+        result.status = CTSAsyncParseStatus::Cancelled;
+        result.tree   = nullptr;
+        result.changed_ranges.clear();
+    }
+    else if (result.status == CTSAsyncParseStatus::Completed)
+    {
+        document->tree         = result.tree;
+        document->tree_version = job->request.version;
+        document->carry_valid  = true;
+    }
+    else
+    {
+        // The last completed tree stays the base; remember how the text has
+        // moved on from it so the next version can still reparse from it.
+        if (use_base)
+        {
+            document->carry_edits = std::move(edits);
+        }
+        else
+        {
+            document->carry_valid = false;
+        }
+
+        if ((result.status == CTSAsyncParseStatus::Cancelled) && document->pending)
+        {
+            result.status = CTSAsyncParseStatus::Superseded;
+        }
+    }
+
+    if (document->closed && !document->pending)
+    {
+        m_documents.erase(document->id);
+    }
+    else if (document->pending)
+    {
+        // The document was skipped while in flight; let another worker see it.
+        m_wake.notify_one();
+    }
+
+    // The job counts as running until its result has been delivered, so that
+    // WaitIdle does not return before the last callback or future.
+    lock.unlock();
+    Resolve(std::move(job), std::move(result));
+    lock.lock();
+
+    m_running--;
+
+    if (m_queue.empty() && (m_running == 0))
+    {
+        m_idle.notify_all();
+    }
+}
+
+void CTSAsyncParseService::Resolved()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_running--;
+
+    if (m_queue.empty() && (m_running == 0))
+    {
+        m_idle.notify_all();
+    }
+}
+
+void CTSAsyncParseService::Resolve(std::unique_ptr<Job> job, CTSAsyncParseResult result)
+{
+    if (job->callback)
+    {
+        job->callback(result);
+    }
+    else
+    {
+        job->promise.set_value(std::move(result));
+    }
+}
+
+CTSAsyncParseResult CTSAsyncParseService::Outcome(const Job& job, CTSAsyncParseStatus status)
+{
+    CTSAsyncParseResult retval;
+
+    retval.document_id = job.request.document_id;
+    retval.version     = job.request.version;
+    retval.status      = status;
+    return retval;
+}
+
+std::shared_ptr<CTSTree>CTSAsyncParseService::Tree(const std::string& document_id, uint64_t *version) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto found = m_documents.find(document_id);
+
+    if ((found == m_documents.end()) || !found->second->tree)
+    {
+        return nullptr;
+    }
+
+    if (version)
+    {
+        *version = found->second->tree_version;
+    }
+    return found->second->tree;
+}
+
+void CTSAsyncParseService::Close(const std::string& document_id)
+{
+    std::unique_ptr<Job> cancelled;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        const auto found = m_documents.find(document_id);
+
+        if (found == m_documents.end())
+        {
+            return;
+        }
+
+        Document *document = found->second.get();
+
+        if (document->pending)
+        {
+            cancelled = std::move(document->pending);
+            m_queue.erase(std::find(m_queue.begin(), m_queue.end(), document));
+            m_running++;
+        }
+
+        if (document->in_flight)
+        {
+            // The worker drops the document once the parse has stopped.
+            document->closed = true;
+            document->generation++;
+            document->token.Cancel();
+            document->tree = nullptr;
+            document->carry_edits.clear();
+            document->carry_valid = true;
+        }
+        else
+        {
+            m_documents.erase(found);
+        }
+    }
+    m_space.notify_all();
+
+    if (cancelled)
+    {
+        const auto result = Outcome(*cancelled, CTSAsyncParseStatus::Cancelled);
+        Resolve(std::move(cancelled), result);
+        Resolved();
+    }
+}
+
+size_t CTSAsyncParseService::QueueSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_queue.size();
+}
+
+void CTSAsyncParseService::WaitIdle() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_idle.wait(lock, [&]()
+                {
+                    return m_queue.empty() && (m_running == 0);
+                });
+}
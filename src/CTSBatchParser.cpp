@@ -0,0 +1,108 @@
+#include "CTSBatchParser.h"
+#include "CTSMappedFile.h"
+#include "CTSParseTask.h"
+
+#include <mutex>
+
+CTSBatchParser::CTSBatchParser(const TSLanguage *language, unsigned thread_count) :
+    m_pool(thread_count)
+{
+    for (unsigned idx = 0; idx < m_pool.ThreadCount(); idx++)
+    {
+        m_parsers.push_back(std::make_unique<CTSParser>(language));
+        m_set_lang_result = m_set_lang_result && m_parsers.back()->LanguageSetResult();
+    }
+}
+
+CTSBatchParser::~CTSBatchParser() = default;
+
+std::shared_ptr<CTSTree>CTSBatchParser::ParseItem(const CTSBatchItem& item, unsigned worker) const
+{
+    const CTSParser& parser = *m_parsers[worker];
+
+    return item.is_file ? parser.ParseFile(item.path) : parser.ParseString(item.buffer);
+}
+
+std::shared_ptr<CTSTree>CTSBatchParser::ParseItem(const CTSBatchItem        & item,
+                                                  unsigned                    worker,
+                                                  const CTSCancellationToken& token) const
+{
+    if (token.IsCancelled())
+    {
+        return nullptr;
+    }
+
+    if (!item.is_file)
+    {
+        CTSParseTask task(*m_parsers[worker], item.buffer, nullptr, token);
+
+        task.Run();
+        return task.Tree();
+    }
+
+    const CTSMappedFile file(item.path);
+
+    if (!file.IsValid() || (file.Size() > UINT32_MAX))
+    {
+        return nullptr;
+    }
+
+    CTSParseTask task(*m_parsers[worker], file.View(), nullptr, token, item.path);
+
+    task.Run();
+    return task.Tree();
+}
+
+std::vector<std::shared_ptr<CTSTree> >CTSBatchParser::ParseAll(const std::vector<CTSBatchItem>& items)
+{
+    std::vector<std::shared_ptr<CTSTree> > retval(items.size());
+
+    // Each index is written by exactly one task, so no locking is needed.
+    m_pool.ParallelFor(items.size(), [&](size_t index, unsigned worker)
+                       {
+                           retval[index] = ParseItem(items[index], worker);
+                       });
+
+    return retval;
+}
+
+std::vector<std::shared_ptr<CTSTree> >CTSBatchParser::ParseAll(const std::vector<CTSBatchItem>& items,
+                                                               const CTSCancellationToken     & token)
+{
+    std::vector<std::shared_ptr<CTSTree> > retval(items.size());
+
+    m_pool.ParallelFor(items.size(), [&](size_t index, unsigned worker)
+                       {
+                           retval[index] = ParseItem(items[index], worker, token);
+                       });
+
+    return retval;
+}
+
+void CTSBatchParser::ParseEach(const std::vector<CTSBatchItem>& items, const Completion& on_complete)
+{
+    std::mutex completion_mutex;
+
+    m_pool.ParallelFor(items.size(), [&](size_t index, unsigned worker)
+                       {
+                           const auto tree = ParseItem(items[index], worker);
+
+                           std::lock_guard<std::mutex> lock(completion_mutex);
+                           on_complete(index, tree);
+                       });
+}
+
+void CTSBatchParser::ParseEach(const std::vector<CTSBatchItem>& items,
+                               const Completion               & on_complete,
+                               const CTSCancellationToken     & token)
+{
+    std::mutex completion_mutex;
+
+    m_pool.ParallelFor(items.size(), [&](size_t index, unsigned worker)
+                       {
+                           const auto tree = ParseItem(items[index], worker, token);
+
+                           std::lock_guard<std::mutex> lock(completion_mutex);
+                           on_complete(index, tree);
+                       });
+}
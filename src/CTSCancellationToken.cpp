@@ -0,0 +1,34 @@
+#include "CTSCancellationToken.h"
+
+// tree-sitter reads the flag through a plain size_t pointer.
+static_assert(sizeof(std::atomic<size_t>) == sizeof(size_t), "std::atomic<size_t> must have the layout of size_t");
+static_assert(std::atomic<size_t>::is_always_lock_free, "std::atomic<size_t> must be lock free");
+
+CTSCancellationToken::CTSCancellationToken() : m_state(std::make_shared<State>())
+{
+}
+
+CTSCancellationToken::CTSCancellationToken(Clock::time_point deadline) : m_state(std::make_shared<State>())
+{
+    m_state->deadline = deadline;
+}
+
+void CTSCancellationToken::Cancel() const
+{
+    m_state->flag.store(1, std::memory_order_release);
+}
+
+bool CTSCancellationToken::IsCancelRequested() const
+{
+    return m_state->flag.load(std::memory_order_acquire) != 0;
+}
+
+bool CTSCancellationToken::IsCancelled() const
+{
+    return IsCancelRequested() || (HasDeadline() && (Clock::now() >= m_state->deadline));
+}
+
+const size_t * CTSCancellationToken::Flag() const
+{
+    return reinterpret_cast<const size_t *>(&m_state->flag);
+}
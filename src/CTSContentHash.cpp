@@ -0,0 +1,112 @@
+#include "CTSContentHash.h"
+
+#include <cstring>
+
+namespace
+{
+constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t RotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t Read64(const unsigned char *data)
+{
+    uint64_t retval;
+
+    std::memcpy(&retval, data, sizeof(retval));
+    return retval;
+}
+
+inline uint32_t Read32(const unsigned char *data)
+{
+    uint32_t retval;
+
+    std::memcpy(&retval, data, sizeof(retval));
+    return retval;
+}
+
+inline uint64_t Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * Prime2;
+    accumulator  = RotateLeft(accumulator, 31);
+    return accumulator * Prime1;
+}
+
+inline uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= Round(0, value);
+    return accumulator * Prime1 + Prime4;
+}
+}
+
+uint64_t CTSContentHash(std::string_view content, uint64_t seed)
+{
+    const auto *data = reinterpret_cast<const unsigned char *>(content.data());
+    const auto *end  = data + content.size();
+
+    uint64_t hash;
+
+    if (content.size() >= 32)
+    {
+        // Four independent lanes keep the multiplier busy.
+        uint64_t v1 = seed + Prime1 + Prime2;
+        uint64_t v2 = seed + Prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - Prime1;
+
+        const unsigned char *limit = end - 32;
+
+        do
+        {
+            v1    = Round(v1, Read64(data));
+            v2    = Round(v2, Read64(data + 8));
+            v3    = Round(v3, Read64(data + 16));
+            v4    = Round(v4, Read64(data + 24));
+            data += 32;
+        } while (data <= limit);
+
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + Prime5;
+    }
+
+    hash += static_cast<uint64_t>(content.size());
+
+    for (; data + 8 <= end; data += 8)
+    {
+        hash ^= Round(0, Read64(data));
+        hash  = RotateLeft(hash, 27) * Prime1 + Prime4;
+    }
+
+    if (data + 4 <= end)
+    {
+        hash ^= static_cast<uint64_t>(Read32(data)) * Prime1;
+        hash  = RotateLeft(hash, 23) * Prime2 + Prime3;
+        data += 4;
+    }
+
+    for (; data < end; data++)
+    {
+        hash ^= static_cast<uint64_t>(*data) * Prime5;
+        hash  = RotateLeft(hash, 11) * Prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,122 @@
+#include "CTSDocumentStore.h"
+
+CTSDocumentSnapshot::CTSDocumentSnapshot(std::string                        document_id,
+                                         uint64_t                           version,
+                                         std::shared_ptr<CTSTree>           tree,
+                                         std::shared_ptr<const std::string> source) :
+    m_document_id(std::move(document_id)),
+    m_version(version),
+    m_tree(std::move(tree)),
+    m_source(std::move(source))
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CTSDocumentStore::CTSDocumentStore() : m_documents(std::make_shared<const Map>())
+{
+}
+
+std::shared_ptr<CTSDocumentStore::Slot>CTSDocumentStore::FindSlot(const std::string& document_id) const
+{
+    const auto documents = std::atomic_load(&m_documents);
+    const auto found     = documents->find(document_id);
+
+    return (found != documents->end()) ? found->second : nullptr;
+}
+
+CTSDocumentStore::SnapshotPtr CTSDocumentStore::Publish(const std::string                & document_id,
+                                                        uint64_t                           version,
+                                                        const std::shared_ptr<CTSTree>   & tree,
+                                                        std::shared_ptr<const std::string> source)
+{
+    if (!tree)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+
+    auto slot = FindSlot(document_id);
+
+    if (slot)
+    {
+        const auto current = std::atomic_load(&slot->snapshot);
+
+        if (current && (current->Version() >= version))
+        {
+            return nullptr;
+        }
+    }
+
+    // The copy shares every node with the writer's tree, but the writer's
+    // later edits only touch its own copy.
+    SnapshotPtr retval(new CTSDocumentSnapshot(document_id, version, tree->Copy(tree.get()), std::move(source)));
+
+    if (slot)
+    {
+        std::atomic_store(&slot->snapshot, retval);
+        return retval;
+    }
+
+    slot           = std::make_shared<Slot>();
+    slot->snapshot = retval;
+
+    auto documents = std::make_shared<Map>(*std::atomic_load(&m_documents));
+
+    (*documents)[document_id] = std::move(slot);
+    std::atomic_store(&m_documents, std::shared_ptr<const Map>(std::move(documents)));
+    return retval;
+}
+
+CTSDocumentStore::SnapshotPtr CTSDocumentStore::Snapshot(const std::string& document_id) const
+{
+    const auto slot = FindSlot(document_id);
+
+    return slot ? std::atomic_load(&slot->snapshot) : nullptr;
+}
+
+uint64_t CTSDocumentStore::Version(const std::string& document_id) const
+{
+    const auto snapshot = Snapshot(document_id);
+
+    return snapshot ? snapshot->Version() : 0;
+}
+
+bool CTSDocumentStore::Remove(const std::string& document_id)
+{
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+
+    const auto current = std::atomic_load(&m_documents);
+
+    if (current->find(document_id) == current->end())
+    {
+        return false;
+    }
+
+    auto documents = std::make_shared<Map>(*current);
+
+    documents->erase(document_id);
+    std::atomic_store(&m_documents, std::shared_ptr<const Map>(std::move(documents)));
+    return true;
+}
+
+std::vector<std::string>CTSDocumentStore::DocumentIds() const
+{
+    const auto documents = std::atomic_load(&m_documents);
+
+    std::vector<std::string> retval;
+
+    retval.reserve(documents->size());
+
+    for (const auto& entry : *documents)
+    {
+        retval.push_back(entry.first);
+    }
+    return retval;
+}
+
+size_t CTSDocumentStore::DocumentCount() const
+{
+    return std::atomic_load(&m_documents)->size();
+}
@@ -0,0 +1,352 @@
+#include "CTSFlatTree.h"
+#include "CTSMappedFile.h"
+#include "CTSSymbolTable.h"
+#include "CTSTreeWalker.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+uint64_t ProcessId()
+{
+#ifdef _WIN32
+    return GetCurrentProcessId();
+#else
+    return static_cast<uint64_t>(getpid());
+#endif
+}
+
+struct CountVisitor
+{
+    uint32_t count = 0;
+
+    CTSVisitAction Enter(const CTSTreeCursor&, uint32_t)
+    {
+        count++;
+        return CTSVisitAction::Continue;
+    }
+
+    void Leave(const CTSTreeCursor&, uint32_t) {}
+};
+
+constexpr char     FileMagic[8] = { 'C', 'T', 'S', 'F', 'L', 'A', 'T', '\0' };
+constexpr uint32_t ByteOrderMark = 0x01020304;
+}
+
+// The header is padded to 64 bytes, which keeps every column that follows it
+// in a mapped file naturally aligned.
+struct CTSFlatTree::FileHeader
+{
+    char     magic[8];
+    uint32_t format_version;
+    uint32_t byte_order;
+    uint64_t language_fingerprint;
+    uint64_t source_hash;
+    uint32_t language_version;
+    uint32_t node_count;
+    uint8_t  reserved[24];
+};
+
+CTSFlatTree::CTSFlatTree(const std::shared_ptr<CTSTree>& tree) : m_tree(tree)
+{
+    if (!m_tree)
+    {
+        return;
+    }
+
+    const CTSNode root = m_tree->RootNode();
+
+    // First pass sizes the single allocation that holds every column.
+    CountVisitor counter;
+    CTSTreeWalker::Walk(root, counter);
+
+    m_storage.reset(new unsigned char[StorageSize(counter.count)], std::default_delete<unsigned char[]>());
+    Bind(m_storage.get(), counter.count);
+
+    // Second pass fills the columns in pre-order. `path` holds the indices of
+    // the ancestors of the current node, `previous` the index of the last
+    // node entered at each depth, so siblings can be linked up.
+    std::vector<uint32_t> path;
+    std::vector<uint32_t> previous;
+    uint32_t              next = 0;
+
+    CTSTreeWalker::Walk(root,
+                        [&](const CTSTreeCursor& cursor, uint32_t depth)
+                        {
+                            const CTSNode  node  = cursor.CurrentNode();
+                            const uint32_t index = next++;
+
+                            path.resize(depth);
+                            previous.resize(depth + 1, NoNode);
+
+                            m_symbols[index]        = node.Symbol();
+                            m_start_bytes[index]    = node.StartByte();
+                            m_end_bytes[index]      = node.EndByte();
+                            m_start_points[index]   = node.StartPoint();
+                            m_end_points[index]     = node.EndPoint();
+                            m_first_children[index] = NoNode;
+                            m_next_siblings[index]  = NoNode;
+                            m_field_ids[index]      = (depth > 0) ? cursor.CurrentFieldId() : 0;
+
+                            uint8_t flags = 0;
+
+                            if (node.IsNamed()) { flags |= FlagNamed; }
+                            if (node.IsMissing()) { flags |= FlagMissing; }
+                            if (node.IsExtra()) { flags |= FlagExtra; }
+                            if (node.HasError()) { flags |= FlagHasError; }
+                            if (m_symbols[index] == CTSErrorSymbol) { flags |= FlagIsError; }
+                            m_flags[index] = flags;
+
+                            if (depth == 0)
+                            {
+                                m_parents[index]       = NoNode;
+                                m_child_indices[index] = 0;
+                            }
+                            else
+                            {
+                                const uint32_t parent  = path[depth - 1];
+                                const uint32_t sibling = previous[depth];
+
+                                m_parents[index] = parent;
+
+                                if (sibling == NoNode)
+                                {
+                                    m_first_children[parent] = index;
+                                    m_child_indices[index]   = 0;
+                                }
+                                else
+                                {
+                                    m_next_siblings[sibling] = index;
+                                    m_child_indices[index]   = m_child_indices[sibling] + 1;
+                                }
+                            }
+
+                            previous[depth] = index;
+                            path.push_back(index);
+
+                            // Children of this node start a fresh sibling chain.
+                            if (previous.size() > depth + 1)
+                            {
+                                previous[depth + 1] = NoNode;
+                            }
+                            return CTSVisitAction::Continue;
+                        },
+                        [](const CTSTreeCursor&, uint32_t) {});
+}
+
+size_t CTSFlatTree::StorageSize(uint32_t count)
+{
+    // Widest columns first so that every column stays naturally aligned.
+    return static_cast<size_t>(count) * (2 * sizeof(TSPoint) +
+                                         6 * sizeof(uint32_t) +
+                                         sizeof(TSSymbol) +
+                                         sizeof(TSFieldId) +
+                                         sizeof(uint8_t));
+}
+
+void CTSFlatTree::Bind(unsigned char *base, uint32_t count)
+{
+    m_count = count;
+
+    m_start_points   = reinterpret_cast<TSPoint *>(base);
+    m_end_points     = m_start_points + count;
+    m_start_bytes    = reinterpret_cast<uint32_t *>(m_end_points + count);
+    m_end_bytes      = m_start_bytes + count;
+    m_parents        = m_end_bytes + count;
+    m_first_children = m_parents + count;
+    m_next_siblings  = m_first_children + count;
+    m_child_indices  = m_next_siblings + count;
+    m_symbols        = reinterpret_cast<TSSymbol *>(m_child_indices + count);
+    m_field_ids      = reinterpret_cast<TSFieldId *>(m_symbols + count);
+    m_flags          = reinterpret_cast<uint8_t *>(m_field_ids + count);
+}
+
+uint32_t CTSFlatTree::SubtreeEnd(uint32_t index) const
+{
+    // In pre-order, the subtree ends where the next sibling of the node, or
+    // of its nearest ancestor that has one, begins.
+    for (uint32_t current = index; current != NoNode; current = m_parents[current])
+    {
+        if (m_next_siblings[current] != NoNode)
+        {
+            return m_next_siblings[current];
+        }
+    }
+    return m_count;
+}
+
+CTSNode CTSFlatTree::Node(uint32_t index) const
+{
+    if (!m_tree || (index >= m_count))
+    {
+        return {};
+    }
+
+    std::vector<uint32_t> path;
+
+    for (uint32_t current = index; m_parents[current] != NoNode; current = m_parents[current])
+    {
+        path.push_back(m_child_indices[current]);
+    }
+
+    CTSNode retval = m_tree->RootNode();
+
+    for (auto it = path.rbegin(); it != path.rend(); ++it)
+    {
+        retval = retval.Child(*it);
+    }
+    return retval;
+}
+
+CTSFlatTree::CTSFlatTree(std::shared_ptr<unsigned char> storage, uint32_t count) : m_storage(std::move(storage))
+{
+    Bind(m_storage.get(), count);
+}
+
+bool CTSFlatTree::Save(const std::string& path, uint64_t source_hash) const
+{
+    static_assert(sizeof(FileHeader) == 64, "flat tree file header must stay 64 bytes");
+
+    FileHeader header = {};
+
+    std::memcpy(header.magic, FileMagic, sizeof(header.magic));
+    header.format_version = FormatVersion;
+    header.byte_order     = ByteOrderMark;
+    header.source_hash    = source_hash;
+    header.node_count     = m_count;
+
+    if (m_tree)
+    {
+        const CTSLanguage language(m_tree->Language());
+
+        header.language_fingerprint = language.Fingerprint();
+        header.language_version     = language.Version();
+    }
+    else if (m_language_fingerprint)
+    {
+        header.language_fingerprint = m_language_fingerprint;
+        header.language_version     = m_language_version;
+    }
+    else
+    {
+        return false;
+    }
+
+    // A unique temporary name per writer, so that processes sharing a cache
+    // directory never write into the same file. Thread ids and the counter
+    // only tell writers of one process apart; the process id does the rest.
+    static std::atomic<uint64_t> counter{ 0 };
+
+    const std::string temp_path = path + "." + std::to_string(ProcessId()) + "." +
+                                  std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "." +
+                                  std::to_string(counter++) + ".tmp";
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        if (m_count > 0)
+        {
+            out.write(reinterpret_cast<const char *>(m_storage.get()), static_cast<std::streamsize>(StorageSize(m_count)));
+        }
+
+        out.close();
+
+        if (!out)
+        {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    // rename() does not replace an existing file on Windows.
+    std::remove(path.c_str());
+#endif
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<CTSFlatTree>CTSFlatTree::Load(const std::string& path, const CTSLanguage& language, uint64_t source_hash)
+{
+    auto file = std::make_shared<CTSMappedFile>(path);
+
+    if (!file->IsValid() || (file->Size() < sizeof(FileHeader)))
+    {
+        return nullptr;
+    }
+
+    FileHeader header;
+
+    std::memcpy(&header, file->Data(), sizeof(header));
+
+    if ((std::memcmp(header.magic, FileMagic, sizeof(header.magic)) != 0) ||
+        (header.format_version != FormatVersion) ||
+        (header.byte_order != ByteOrderMark) ||
+        (header.language_fingerprint != language.Fingerprint()) ||
+        (header.source_hash != source_hash) ||
+        (file->Size() != sizeof(FileHeader) + StorageSize(header.node_count)))
+    {
+        return nullptr;
+    }
+
+    // The columns are only ever read, so they can point straight into the
+    // read-only mapping, which the storage pointer keeps alive.
+    auto *base = reinterpret_cast<unsigned char *>(const_cast<char *>(file->Data())) + sizeof(FileHeader);
+
+    std::shared_ptr<CTSFlatTree> retval(new CTSFlatTree(std::shared_ptr<unsigned char>(file, base), header.node_count));
+
+    retval->m_language_version     = header.language_version;
+    retval->m_language_fingerprint = header.language_fingerprint;
+    retval->m_source_hash          = header.source_hash;
+
+    return retval->IsConsistent() ? retval : nullptr;
+}
+
+bool CTSFlatTree::IsConsistent() const
+{
+    // Every link must point forward within the columns, except parents,
+    // which point back; the root alone has none. This is enough for every
+    // traversal of the columns to stay in bounds.
+    for (uint32_t index = 0; index < m_count; index++)
+    {
+        const uint32_t parent  = m_parents[index];
+        const uint32_t child   = m_first_children[index];
+        const uint32_t sibling = m_next_siblings[index];
+
+        if ((index == 0) ? (parent != NoNode) : (parent >= index))
+        {
+            return false;
+        }
+
+        if ((child != NoNode) && ((child <= index) || (child >= m_count)))
+        {
+            return false;
+        }
+
+        if ((sibling != NoNode) && ((sibling <= index) || (sibling >= m_count)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,262 @@
+#include "CTSIncrementalQuery.h"
+#include "CTSInputEdit.h"
+
+#include <algorithm>
+
+namespace
+{
+bool Intersects(const TSRange& range, uint32_t start, uint32_t end)
+{
+    // An empty span still occupies its start position.
+    return (start < range.end_byte) && (range.start_byte < std::max(end, start + 1));
+}
+
+bool IntersectsAny(const std::vector<TSRange>& ranges, size_t limit, uint32_t start, uint32_t end)
+{
+    for (size_t idx = 0; idx < limit; idx++)
+    {
+        if (Intersects(ranges[idx], start, end))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
+CTSIncrementalQuery::CTSIncrementalQuery(const CTSQuery          & query,
+                                         const CTSQueryPredicates *predicates,
+                                         uint32_t                  context_depth) :
+    m_query(query),
+    m_predicates(predicates),
+    m_context_depth(context_depth)
+{
+}
+
+void CTSIncrementalQuery::Run(const std::shared_ptr<CTSTree>& tree, std::string_view source)
+{
+    m_tree = tree;
+    m_matches.clear();
+    m_updated.clear();
+
+    if (!m_tree)
+    {
+        return;
+    }
+
+    const CTSNode root = m_tree->RootNode();
+
+    m_updated.push_back({ root.StartPoint(), root.EndPoint(), 0, UINT32_MAX });
+    Execute(m_updated, 0, source, m_matches);
+    m_updated.front().start_byte = root.StartByte();
+    m_updated.front().end_byte   = root.EndByte();
+}
+
+void CTSIncrementalQuery::Update(const std::shared_ptr<CTSTree>& new_tree,
+                                 const std::vector<TSInputEdit>& edits,
+                                 std::string_view                source)
+{
+    if (!m_tree || !new_tree)
+    {
+        Run(new_tree, source);
+        return;
+    }
+
+    Update(new_tree, edits, m_tree->GetChangedRanges(new_tree), source);
+}
+
+void CTSIncrementalQuery::Update(const std::shared_ptr<CTSTree>& new_tree,
+                                 const std::vector<TSInputEdit>& edits,
+                                 const std::vector<TSRange>    & changed_ranges,
+                                 std::string_view                source)
+{
+    if (!m_tree || !new_tree)
+    {
+        Run(new_tree, source);
+        return;
+    }
+
+    m_tree = new_tree;
+
+    // Dirty ranges in the coordinates of the new tree. Edits apply one after
+    // another, so each edit also moves what earlier edits dirtied.
+    std::vector<TSRange> dirty;
+
+    for (const TSInputEdit& edit : edits)
+    {
+        for (TSRange& range : dirty)
+        {
+            CTSShiftPosition(range.start_byte, range.start_point, edit);
+            CTSShiftPosition(range.end_byte, range.end_point, edit);
+        }
+
+        for (CTSIncrementalMatch& match : m_matches)
+        {
+            TSPoint unused{};
+
+            CTSShiftPosition(match.start_byte, unused, edit);
+            CTSShiftPosition(match.end_byte, unused, edit);
+
+            for (CTSIncrementalCapture& capture : match.captures)
+            {
+                CTSShiftPosition(capture.start_byte, capture.start_point, edit);
+                CTSShiftPosition(capture.end_byte, capture.end_point, edit);
+            }
+        }
+
+        dirty.push_back({ edit.start_point, edit.new_end_point, edit.start_byte, edit.new_end_byte });
+    }
+
+    dirty.insert(dirty.end(), changed_ranges.begin(), changed_ranges.end());
+
+    // Widen, then merge into ordered, disjoint ranges.
+    m_updated.clear();
+
+    for (const TSRange& range : dirty)
+    {
+        m_updated.push_back(Widen(range));
+    }
+
+    std::sort(m_updated.begin(), m_updated.end(),
+              [](const TSRange& a, const TSRange& b) { return a.start_byte < b.start_byte; });
+
+    size_t merged = 0;
+
+    for (size_t idx = 0; idx < m_updated.size(); idx++)
+    {
+        if ((merged > 0) && (m_updated[idx].start_byte <= m_updated[merged - 1].end_byte))
+        {
+            TSRange& last = m_updated[merged - 1];
+
+            if (m_updated[idx].end_byte > last.end_byte)
+            {
+                last.end_byte  = m_updated[idx].end_byte;
+                last.end_point = m_updated[idx].end_point;
+            }
+        }
+        else
+        {
+            m_updated[merged++] = m_updated[idx];
+        }
+    }
+    m_updated.resize(merged);
+
+    // Keep what lies clear of every widened range, re-run the rest.
+    std::vector<CTSIncrementalMatch> matches;
+
+    for (CTSIncrementalMatch& match : m_matches)
+    {
+        if (!IntersectsAny(m_updated, m_updated.size(), match.start_byte, match.end_byte))
+        {
+            matches.push_back(std::move(match));
+        }
+    }
+
+    const size_t kept = matches.size();
+
+    for (size_t idx = 0; idx < m_updated.size(); idx++)
+    {
+        Execute(m_updated, idx, source, matches);
+    }
+
+    std::inplace_merge(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(kept), matches.end(),
+                       [](const CTSIncrementalMatch& a, const CTSIncrementalMatch& b) { return a.start_byte < b.start_byte; });
+
+    m_matches = std::move(matches);
+}
+
+void CTSIncrementalQuery::Execute(const std::vector<TSRange>      & ranges,
+                                  size_t                            range_index,
+                                  std::string_view                  source,
+                                  std::vector<CTSIncrementalMatch>& out)
+{
+    const TSRange& range = ranges[range_index];
+    const size_t   first = out.size();
+
+    m_cursor.SetByteRange(range.start_byte, range.end_byte);
+    m_cursor.Exec(m_query, m_tree->RootNode());
+
+    while (m_predicates ? m_cursor.NextMatch(*m_predicates, source) : m_cursor.NextMatch())
+    {
+        const TSQueryMatch match = m_cursor.GetMatchResult();
+
+        if (match.capture_count == 0)
+        {
+            continue;
+        }
+
+        CTSIncrementalMatch entry{ match.pattern_index, UINT32_MAX, 0, {} };
+
+        entry.captures.reserve(match.capture_count);
+
+        for (uint16_t idx = 0; idx < match.capture_count; idx++)
+        {
+            const CTSNode node = match.captures[idx].node;
+
+            entry.captures.push_back({ match.captures[idx].index, node.StartByte(), node.EndByte(),
+                                       node.StartPoint(), node.EndPoint() });
+            entry.start_byte = std::min(entry.start_byte, node.StartByte());
+            entry.end_byte   = std::max(entry.end_byte, node.EndByte());
+        }
+
+        // The cursor also reports matches that merely start or end inside the
+        // range; those belong to whichever range their captures touch first,
+        // or were kept from before if they touch none.
+        if (!Intersects(range, entry.start_byte, entry.end_byte) ||
+            IntersectsAny(ranges, range_index, entry.start_byte, entry.end_byte))
+        {
+            continue;
+        }
+
+        out.push_back(std::move(entry));
+    }
+
+    std::stable_sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+                     [](const CTSIncrementalMatch& a, const CTSIncrementalMatch& b) { return a.start_byte < b.start_byte; });
+}
+
+TSRange CTSIncrementalQuery::Widen(const TSRange& dirty) const
+{
+    const CTSNode root = m_tree->RootNode();
+    CTSNode       node = root.NamedDescendantForByteRange(dirty.start_byte, dirty.end_byte);
+
+    if (node.IsNull())
+    {
+        node = root;
+    }
+
+    // Climb context_depth levels, and further if needed to reach a node that
+    // one of the patterns can start at.
+    const CTSSymbolSet& roots = m_query.RootSymbols();
+
+    bool at_pattern_root = m_query.HasUnrestrictedRoots() || roots.Contains(node);
+
+    for (uint32_t level = 0; (level < m_context_depth) || !at_pattern_root; level++)
+    {
+        const CTSNode parent = node.Parent();
+
+        if (parent.IsNull())
+        {
+            break;
+        }
+        node            = parent;
+        at_pattern_root = at_pattern_root || roots.Contains(node);
+    }
+
+    // Never narrower than the dirty range itself, which may extend past the
+    // node, for instance over deleted trailing text.
+    TSRange retval{ node.StartPoint(), node.EndPoint(), node.StartByte(), node.EndByte() };
+
+    if (dirty.start_byte < retval.start_byte)
+    {
+        retval.start_byte  = dirty.start_byte;
+        retval.start_point = dirty.start_point;
+    }
+
+    if (dirty.end_byte > retval.end_byte)
+    {
+        retval.end_byte  = dirty.end_byte;
+        retval.end_point = dirty.end_point;
+    }
+    return retval;
+}
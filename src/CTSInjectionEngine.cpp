@@ -0,0 +1,442 @@
+#include "CTSInjectionEngine.h"
+#include "CTSInputEdit.h"
+
+#include <algorithm>
+
+namespace
+{
+/**
+ * Move ranges past a sequence of edits. Returns true if any edit touches one
+ * of them, including edits that merely border a range.
+ */
+bool ApplyEdits(std::vector<TSRange>& ranges, const std::vector<TSInputEdit>& edits)
+{
+    bool retval = false;
+
+    for (const TSInputEdit& edit : edits)
+    {
+        for (TSRange& range : ranges)
+        {
+            if ((edit.start_byte <= range.end_byte) && (range.start_byte <= edit.old_end_byte))
+            {
+                retval = true;
+            }
+
+            CTSShiftPosition(range.start_byte, range.start_point, edit);
+            CTSShiftPosition(range.end_byte, range.end_point, edit);
+        }
+    }
+    return retval;
+}
+
+bool SameRanges(const std::vector<TSRange>& a, const std::vector<TSRange>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                      [](const TSRange& x, const TSRange& y)
+                      {
+                          return (x.start_byte == y.start_byte) && (x.end_byte == y.end_byte) &&
+                                 (x.start_point.row == y.start_point.row) &&
+                                 (x.start_point.column == y.start_point.column) &&
+                                 (x.end_point.row == y.end_point.row) &&
+                                 (x.end_point.column == y.end_point.column);
+                      });
+}
+
+/**
+ * Add range to out, clipped to the included ranges of the layer it was found
+ * in, so that an injected layer never reads text its parent did not.
+ */
+void AddClipped(const TSRange& range, const std::vector<TSRange>& parent, std::vector<TSRange>& out)
+{
+    if (range.start_byte >= range.end_byte)
+    {
+        return;
+    }
+
+    if (parent.empty())
+    {
+        out.push_back(range);
+        return;
+    }
+
+    for (const TSRange& bound : parent)
+    {
+        if ((bound.end_byte <= range.start_byte) || (range.end_byte <= bound.start_byte))
+        {
+            continue;
+        }
+
+        TSRange clipped = range;
+
+        if (bound.start_byte > clipped.start_byte)
+        {
+            clipped.start_byte  = bound.start_byte;
+            clipped.start_point = bound.start_point;
+        }
+
+        if (bound.end_byte < clipped.end_byte)
+        {
+            clipped.end_byte  = bound.end_byte;
+            clipped.end_point = bound.end_point;
+        }
+        out.push_back(clipped);
+    }
+}
+
+/**
+ * Add the text of a content node to out. Unless include_children is set, the
+ * text of its children is cut out, leaving the gaps between them.
+ */
+void AddContent(CTSNode node, bool include_children, const std::vector<TSRange>& parent, std::vector<TSRange>& out)
+{
+    TSRange        piece{ node.StartPoint(), node.EndPoint(), node.StartByte(), node.EndByte() };
+    const uint32_t count = include_children ? 0 : node.ChildCount();
+
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        const CTSNode child = node.Child(idx);
+
+        if (child.StartByte() > piece.start_byte)
+        {
+            AddClipped({ piece.start_point, child.StartPoint(), piece.start_byte, child.StartByte() }, parent, out);
+        }
+
+        if (child.EndByte() > piece.start_byte)
+        {
+            piece.start_byte  = child.EndByte();
+            piece.start_point = child.EndPoint();
+        }
+    }
+
+    AddClipped(piece, parent, out);
+}
+
+/**
+ * Sort ranges and merge the ones that overlap or touch, which is the form
+ * `CTSParser::SetIncludedRanges` requires.
+ */
+void Normalize(std::vector<TSRange>& ranges)
+{
+    std::sort(ranges.begin(), ranges.end(),
+              [](const TSRange& a, const TSRange& b) { return a.start_byte < b.start_byte; });
+
+    size_t last = 0;
+
+    for (size_t idx = 1; idx < ranges.size(); idx++)
+    {
+        if (ranges[idx].start_byte <= ranges[last].end_byte)
+        {
+            if (ranges[idx].end_byte > ranges[last].end_byte)
+            {
+                ranges[last].end_byte  = ranges[idx].end_byte;
+                ranges[last].end_point = ranges[idx].end_point;
+            }
+        }
+        else
+        {
+            ranges[++last] = ranges[idx];
+        }
+    }
+
+    if (!ranges.empty())
+    {
+        ranges.resize(last + 1);
+    }
+}
+
+std::shared_ptr<CTSTree> EditedCopy(const std::shared_ptr<CTSTree>& tree, const std::vector<TSInputEdit>& edits)
+{
+    auto retval = tree->Copy(tree.get());
+
+    retval->Edit(edits);
+    return retval;
+}
+}
+
+CTSInjectionEngine::CTSInjectionEngine(const std::string& host,
+                                       const TSLanguage  *language,
+                                       std::string_view   injection_query,
+                                       uint32_t           max_depth) :
+    m_max_depth(max_depth)
+{
+    if (AddLanguage(host, language, injection_query))
+    {
+        m_host = m_languages.front().get();
+    }
+}
+
+bool CTSInjectionEngine::AddLanguage(const std::string& name, const TSLanguage *language, std::string_view injection_query)
+{
+    if (!language || Find(name))
+    {
+        return false;
+    }
+
+    auto entry = std::make_unique<Language>();
+
+    entry->name   = name;
+    entry->parser = std::make_unique<CTSParser>(language);
+
+    if (!entry->parser->LanguageSetResult())
+    {
+        return false;
+    }
+
+    if (!injection_query.empty())
+    {
+        entry->query = std::make_unique<CTSQuery>(language, injection_query);
+
+        if (!entry->query->IsValid())
+        {
+            return false;
+        }
+
+        entry->predicates = std::make_unique<CTSQueryPredicates>(*entry->query);
+
+        for (uint32_t id = 0; id < entry->query->CaptureCount(); id++)
+        {
+            const std::string capture = entry->query->CaptureNameForId(id);
+
+            if (capture == "injection.content")
+            {
+                entry->content_capture = id;
+            }
+            else if (capture == "injection.language")
+            {
+                entry->language_capture = id;
+            }
+        }
+    }
+
+    m_languages.push_back(std::move(entry));
+    return true;
+}
+
+bool CTSInjectionEngine::HasLanguage(std::string_view name) const
+{
+    return Find(name) != nullptr;
+}
+
+CTSInjectionEngine::Language * CTSInjectionEngine::Find(std::string_view name) const
+{
+    for (const auto& language : m_languages)
+    {
+        if (language->name == name)
+        {
+            return language.get();
+        }
+    }
+    return nullptr;
+}
+
+bool CTSInjectionEngine::Parse(std::string_view source)
+{
+    return Run(nullptr, source);
+}
+
+bool CTSInjectionEngine::Update(const std::vector<TSInputEdit>& edits, std::string_view source)
+{
+    return Run(m_layers.empty() ? nullptr : &edits, source);
+}
+
+bool CTSInjectionEngine::Run(const std::vector<TSInputEdit> *edits, std::string_view source)
+{
+    std::vector<CTSInjectionLayer> previous;
+
+    previous.swap(m_layers);
+    m_parse_count = 0;
+
+    if (!m_host)
+    {
+        return false;
+    }
+
+    CTSInjectionLayer host;
+
+    host.language = m_host->name;
+    host.tree     = ParseLayer(*m_host, {}, edits ? EditedCopy(previous.front().tree, *edits) : nullptr, source);
+
+    if (!host.tree)
+    {
+        return false;
+    }
+
+    m_layers.push_back(std::move(host));
+
+    // Breadth-first: the layers of one depth are searched for the regions
+    // that make up the layers of the next.
+    size_t begin = 0;
+
+    for (uint32_t depth = 1; (depth <= m_max_depth) && (begin < m_layers.size()); depth++)
+    {
+        RangeMap found;
+
+        for (size_t idx = begin; idx < m_layers.size(); idx++)
+        {
+            FindInjections(m_layers[idx], source, found);
+        }
+
+        begin = m_layers.size();
+
+        for (auto& entry : found)
+        {
+            Language *language = Find(entry.first);
+
+            Normalize(entry.second);
+
+            if (!language || entry.second.empty())
+            {
+                continue;
+            }
+
+            CTSInjectionLayer layer;
+
+            layer.language = entry.first;
+            layer.depth    = depth;
+            layer.ranges   = std::move(entry.second);
+
+            auto old = std::find_if(previous.begin(), previous.end(),
+                                    [&](const CTSInjectionLayer& candidate)
+                                    {
+                                        return (candidate.depth == depth) && (candidate.language == entry.first);
+                                    });
+
+            if (edits && (old != previous.end()))
+            {
+                std::vector<TSRange> moved   = old->ranges;
+                const bool           touched = ApplyEdits(moved, *edits);
+                auto                 edited  = EditedCopy(old->tree, *edits);
+
+                if (!touched && SameRanges(moved, layer.ranges))
+                {
+                    layer.tree   = std::move(edited);
+                    layer.reused = true;
+                }
+                else
+                {
+                    layer.tree = ParseLayer(*language, layer.ranges, edited, source);
+                }
+            }
+            else
+            {
+                layer.tree = ParseLayer(*language, layer.ranges, nullptr, source);
+            }
+
+            if (layer.tree)
+            {
+                m_layers.push_back(std::move(layer));
+            }
+        }
+    }
+    return true;
+}
+
+void CTSInjectionEngine::FindInjections(const CTSInjectionLayer& layer, std::string_view source, RangeMap& found)
+{
+    const Language *language = Find(layer.language);
+
+    if (!language || !language->query || (language->content_capture == UINT32_MAX))
+    {
+        return;
+    }
+
+    m_cursor.Exec(*language->query, layer.tree->RootNode());
+
+    while (m_cursor.NextMatch(*language->predicates, source))
+    {
+        const TSQueryMatch match = m_cursor.GetMatchResult();
+        std::string_view   name  = language->predicates->Property(match.pattern_index, "injection.language");
+        bool               include_children = false;
+
+        for (const CTSQueryProperty& property : language->predicates->Properties(match.pattern_index))
+        {
+            include_children |= property.key == "injection.include-children";
+        }
+
+        for (uint16_t idx = 0; idx < match.capture_count; idx++)
+        {
+            const TSQueryCapture& capture = match.captures[idx];
+
+            if (capture.index == language->language_capture)
+            {
+                const uint32_t start = std::min<uint32_t>(ts_node_start_byte(capture.node), static_cast<uint32_t>(source.size()));
+                const uint32_t end   = std::min<uint32_t>(ts_node_end_byte(capture.node), static_cast<uint32_t>(source.size()));
+
+                name = source.substr(start, end - std::min(start, end));
+            }
+        }
+
+        if (name.empty())
+        {
+            continue;
+        }
+
+        std::vector<TSRange>& ranges = found[std::string(name)];
+
+        for (uint16_t idx = 0; idx < match.capture_count; idx++)
+        {
+            const TSQueryCapture& capture = match.captures[idx];
+
+            if (capture.index == language->content_capture)
+            {
+                AddContent(capture.node, include_children, layer.ranges, ranges);
+            }
+        }
+    }
+}
+
+std::shared_ptr<CTSTree> CTSInjectionEngine::ParseLayer(Language                      & language,
+                                                        const std::vector<TSRange>    & ranges,
+                                                        const std::shared_ptr<CTSTree>& old_tree,
+                                                        std::string_view                source)
+{
+    // One parser serves every layer of its language, so the included ranges
+    // are set again for each parse.
+    if (!language.parser->SetIncludedRanges(ranges))
+    {
+        return nullptr;
+    }
+
+    m_parse_count++;
+    return language.parser->ParseString(old_tree, source);
+}
+
+std::shared_ptr<CTSTree> CTSInjectionEngine::HostTree() const
+{
+    return m_layers.empty() ? nullptr : m_layers.front().tree;
+}
+
+const CTSInjectionLayer * CTSInjectionEngine::Layer(std::string_view language, uint32_t depth) const
+{
+    for (const CTSInjectionLayer& layer : m_layers)
+    {
+        if ((layer.depth == depth) && (layer.language == language))
+        {
+            return &layer;
+        }
+    }
+    return nullptr;
+}
+
+const CTSInjectionLayer * CTSInjectionEngine::LayerForByte(uint32_t byte) const
+{
+    const CTSInjectionLayer *retval = m_layers.empty() ? nullptr : &m_layers.front();
+
+    for (const CTSInjectionLayer& layer : m_layers)
+    {
+        if (layer.depth <= retval->depth)
+        {
+            continue;
+        }
+
+        for (const TSRange& range : layer.ranges)
+        {
+            if ((range.start_byte <= byte) && (byte < range.end_byte))
+            {
+                retval = &layer;
+                break;
+            }
+        }
+    }
+    return retval;
+}
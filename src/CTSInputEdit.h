@@ -0,0 +1,32 @@
+#pragma once
+
+#include "api.h"
+
+#include <cstdint>
+
+/**
+ * Move a position in the text before edit to where it lies after it.
+ *
+ * Positions before the edit stay put and positions after it move with the end
+ * of the replaced text. Positions inside the replaced text have no
+ * counterpart in the new text, and their old point cannot be translated, so
+ * they move to the end of the new text, byte and point together.
+ */
+inline void CTSShiftPosition(uint32_t& byte, TSPoint& point, const TSInputEdit& edit)
+{
+    if (byte >= edit.old_end_byte)
+    {
+        byte = edit.new_end_byte + (byte - edit.old_end_byte);
+
+        if (point.row == edit.old_end_point.row)
+        {
+            point.column = edit.new_end_point.column + (point.column - edit.old_end_point.column);
+        }
+        point.row = edit.new_end_point.row + (point.row - edit.old_end_point.row);
+    }
+    else if (byte > edit.start_byte)
+    {
+        byte  = edit.new_end_byte;
+        point = edit.new_end_point;
+    }
+}
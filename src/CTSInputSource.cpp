@@ -0,0 +1,163 @@
+#include "CTSInputSource.h"
+
+#include <algorithm>
+
+void CTSInputSource::ResetStatistics()
+{
+    m_last_byte    = 0;
+    m_last_point   = {};
+    m_bytes_served = 0;
+    m_read_count   = 0;
+}
+
+const char * CTSInputSource::Read(void *payload, uint32_t byte, TSPoint point, uint32_t *bytes_read)
+{
+    auto *self = static_cast<CTSInputSource *>(payload);
+
+    uint32_t length    = 0;
+    const char *retval = self->ReadChunk(byte, point, &length);
+
+    if (!retval)
+    {
+        length = 0;
+    }
+
+    self->m_last_byte  = byte;
+    self->m_last_point = point;
+    self->m_read_count++;
+
+    if (length > 0)
+    {
+        self->m_bytes_served = std::max(self->m_bytes_served, byte + length);
+    }
+
+    *bytes_read = length;
+    return retval;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+const char * CTSFunctionInputSource::ReadChunk(uint32_t byte, TSPoint point, uint32_t *length)
+{
+    const std::string_view chunk = m_read(byte, point);
+
+    *length = static_cast<uint32_t>(chunk.length());
+    return chunk.data();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void CTSChunkListInputSource::Append(std::string_view chunk)
+{
+    if (chunk.empty())
+    {
+        return;
+    }
+
+    m_chunks.push_back(chunk);
+    m_offsets.push_back(m_length);
+    m_length += static_cast<uint32_t>(chunk.length());
+}
+
+void CTSChunkListInputSource::Clear()
+{
+    m_chunks.clear();
+    m_offsets.clear();
+    m_length = 0;
+    m_cursor = 0;
+}
+
+const char * CTSChunkListInputSource::ReadChunk(uint32_t byte, TSPoint /*point*/, uint32_t *length)
+{
+    if (byte >= m_length)
+    {
+        *length = 0;
+        return "";
+    }
+
+    // The parser almost always reads forward, so try the current chunk and
+    // its successor before falling back to a binary search.
+    const auto contains = [this](size_t idx, uint32_t offset)
+                          {
+                              return (idx < m_chunks.size()) &&
+                                     (offset >= m_offsets[idx]) &&
+                                     (offset - m_offsets[idx] < m_chunks[idx].length());
+                          };
+
+    if (!contains(m_cursor, byte))
+    {
+        if (contains(m_cursor + 1, byte))
+        {
+            m_cursor++;
+        }
+        else
+        {
+            const auto it = std::upper_bound(m_offsets.begin(), m_offsets.end(), byte);
+            m_cursor = static_cast<size_t>(it - m_offsets.begin()) - 1;
+        }
+    }
+
+    const uint32_t skip = byte - m_offsets[m_cursor];
+
+    *length = static_cast<uint32_t>(m_chunks[m_cursor].length()) - skip;
+    return m_chunks[m_cursor].data() + skip;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CTSStreamInputSource::CTSStreamInputSource(std::istream& stream, size_t block_size) :
+    m_stream(stream),
+    m_base(stream.tellg()),
+    m_block_size(std::max<size_t>(block_size, 1))
+{
+    m_seekable = (m_base != std::streampos(-1));
+}
+
+bool CTSStreamInputSource::Fill(uint32_t byte)
+{
+    if (m_seekable)
+    {
+        m_stream.clear();
+        m_stream.seekg(m_base + std::streamoff(byte));
+
+        m_buffer.resize(m_block_size);
+        m_stream.read(m_buffer.data(), static_cast<std::streamsize>(m_block_size));
+        m_buffer.resize(static_cast<size_t>(m_stream.gcount()));
+        m_buffer_start = byte;
+
+        return !m_buffer.empty();
+    }
+
+    // Without seeking, keep everything read so far so earlier offsets stay available.
+    while (!m_at_end && (m_buffer.size() <= byte))
+    {
+        const size_t old_size = m_buffer.size();
+
+        m_buffer.resize(old_size + m_block_size);
+        m_stream.read(m_buffer.data() + old_size, static_cast<std::streamsize>(m_block_size));
+
+        const auto count = static_cast<size_t>(m_stream.gcount());
+
+        m_buffer.resize(old_size + count);
+        m_at_end = (count < m_block_size);
+    }
+
+    return m_buffer.size() > byte;
+}
+
+const char * CTSStreamInputSource::ReadChunk(uint32_t byte, TSPoint /*point*/, uint32_t *length)
+{
+    const bool in_buffer = (byte >= m_buffer_start) &&
+                           (byte - m_buffer_start < m_buffer.size());
+
+    if (!in_buffer && !Fill(byte))
+    {
+        *length = 0;
+        return "";
+    }
+
+    const size_t skip = byte - m_buffer_start;
+
+    *length = static_cast<uint32_t>(m_buffer.size() - skip);
+    return m_buffer.data() + skip;
+}
@@ -5,20 +5,84 @@
 CTSLanguage::CTSLanguage(const TSLanguage *lang)
 {
     m_language = lang;
+
+    // Symbol and field names are static strings inside the language, so
+    // views of them can be computed once and handed out from then on.
+    const uint32_t symbol_count = SymbolCount();
+
+    m_symbol_names.reserve(symbol_count);
+    m_symbol_hashes.reserve(symbol_count);
+
+    for (uint32_t idx = 0; idx < symbol_count; idx++)
+    {
+        const char *name = ts_language_symbol_name(m_language, static_cast<TSSymbol>(idx));
+        m_symbol_names.emplace_back(name ? name : "");
+        m_symbol_hashes.push_back(CTSNameHash(m_symbol_names.back()));
+    }
+
+    // Field ids start at 1; slot 0 stays empty.
+    const uint32_t field_count = FieldCount();
+
+    m_field_names.reserve(field_count + 1);
+    m_field_names.emplace_back();
+
+    for (uint32_t idx = 1; idx <= field_count; idx++)
+    {
+        const char *name = ts_language_field_name_for_id(m_language, static_cast<TSFieldId>(idx));
+        m_field_names.emplace_back(name ? name : "");
+    }
+
+    // FNV-1a over everything that determines how node types are numbered.
+    auto mix = [this](uint64_t value)
+               {
+                   for (int shift = 0; shift < 64; shift += 8)
+                   {
+                       m_fingerprint ^= (value >> shift) & 0xff;
+                       m_fingerprint *= 0x100000001b3ULL;
+                   }
+               };
+
+    m_fingerprint = 0xcbf29ce484222325ULL;
+    mix(m_language ? Version() : 0);
+    mix(symbol_count);
+
+    for (uint32_t idx = 0; idx < symbol_count; idx++)
+    {
+        mix(m_symbol_hashes[idx]);
+        mix(SymbolType(static_cast<TSSymbol>(idx)));
+    }
+    mix(field_count);
+
+    for (uint32_t idx = 1; idx <= field_count; idx++)
+    {
+        mix(CTSNameHash(m_field_names[idx]));
+    }
 }
 
-inline uint32_t CTSLanguage::SymbolCount() const
+uint32_t CTSLanguage::SymbolCount() const
 {
     return m_language ? ts_language_symbol_count(m_language) : 0;
 }
 
 std::string CTSLanguage::SymbolName(TSSymbol symbol)  const
 {
-    return m_language ? std::string(ts_language_symbol_name(m_language,
-                                                            symbol)) :
+    return m_language ? std::string(SymbolNameView(symbol)) :
            "ERROR: No Language Initialized!";
 }
 
+std::string_view CTSLanguage::SymbolNameView(TSSymbol symbol) const
+{
+    if (symbol < m_symbol_names.size())
+    {
+        return m_symbol_names[symbol];
+    }
+
+    // Built-in symbols such as ERROR live outside the regular symbol range.
+    const char *name = m_language ? ts_language_symbol_name(m_language, symbol) : nullptr;
+
+    return name ? std::string_view(name) : std::string_view();
+}
+
 TSSymbol CTSLanguage::SymbolForName(const std::string& name, bool is_named) const
 {
     return m_language ? ts_language_symbol_for_name(m_language,
@@ -27,18 +91,96 @@ TSSymbol CTSLanguage::SymbolForName(const std::string& name, bool is_named) cons
                                                     is_named) : 0;
 }
 
-inline uint32_t CTSLanguage::FieldCount()  const
+uint32_t CTSLanguage::FieldCount()  const
 {
     return m_language ? ts_language_field_count(m_language) : 0;
 }
 
-inline std::string CTSLanguage::FieldNameForId(TSFieldId id)  const
+std::string CTSLanguage::FieldNameForId(TSFieldId id)  const
 {
-    return m_language ? std::string(ts_language_field_name_for_id(m_language,
-                                                                  id)) :
+    return m_language ? std::string(FieldNameViewForId(id)) :
            "Error: No Language Initialized!";
 }
 
+uint64_t CTSLanguage::SymbolHash(TSSymbol symbol) const
+{
+    return (symbol < m_symbol_hashes.size()) ? m_symbol_hashes[symbol] :
+           CTSNameHash(SymbolNameView(symbol));
+}
+
+std::vector<TSSymbol>CTSLanguage::SymbolsForName(std::string_view name) const
+{
+    std::vector<TSSymbol> retval;
+    const uint64_t        hash = CTSNameHash(name);
+
+    for (size_t idx = 0; idx < m_symbol_hashes.size(); idx++)
+    {
+        if ((m_symbol_hashes[idx] == hash) && (m_symbol_names[idx] == name))
+        {
+            retval.push_back(static_cast<TSSymbol>(idx));
+        }
+    }
+
+    // Built-in symbols such as ERROR are outside the table, but the library
+    // still resolves them by name.
+    if (retval.empty() && m_language)
+    {
+        for (const bool is_named : { true, false })
+        {
+            const TSSymbol symbol = ts_language_symbol_for_name(m_language, name.data(),
+                                                                static_cast<uint32_t>(name.length()),
+                                                                is_named);
+
+            if (symbol != 0)
+            {
+                retval.push_back(symbol);
+                break;
+            }
+        }
+    }
+    return retval;
+}
+
+CTSSymbolSet CTSLanguage::ResolveSymbols(std::initializer_list<std::string_view> names) const
+{
+    CTSSymbolSet retval;
+
+    for (const auto name : names)
+    {
+        for (const TSSymbol symbol : SymbolsForName(name))
+        {
+            retval.Insert(symbol);
+        }
+    }
+    return retval;
+}
+
+std::vector<TSFieldId>CTSLanguage::ResolveFields(std::initializer_list<std::string_view> names) const
+{
+    std::vector<TSFieldId> retval;
+
+    for (const auto name : names)
+    {
+        TSFieldId id = 0;
+
+        for (size_t idx = 1; idx < m_field_names.size(); idx++)
+        {
+            if (m_field_names[idx] == name)
+            {
+                id = static_cast<TSFieldId>(idx);
+                break;
+            }
+        }
+        retval.push_back(id);
+    }
+    return retval;
+}
+
+std::string_view CTSLanguage::FieldNameViewForId(TSFieldId id) const
+{
+    return (id < m_field_names.size()) ? m_field_names[id] : std::string_view();
+}
+
 TSFieldId CTSLanguage::FieldIdForName(const std::string& name) const
 {
     return m_language ? ts_language_field_id_for_name(m_language, name.c_str(), static_cast<uint32_t>(name.length())) : 0;
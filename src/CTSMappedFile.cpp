@@ -0,0 +1,131 @@
+#include "CTSMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+CTSMappedFile::CTSMappedFile(const std::string& path)
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    m_file = file;
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    if (m_size == 0)
+    {
+        // Zero-length files cannot be mapped, but they are still valid input.
+        m_valid = true;
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (!mapping)
+    {
+        return;
+    }
+
+    m_mapping = mapping;
+    m_data    = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    m_valid   = (m_data != nullptr);
+}
+
+CTSMappedFile::~CTSMappedFile()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+
+    if (m_mapping)
+    {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+        m_mapping = nullptr;
+    }
+
+    if (m_file)
+    {
+        CloseHandle(static_cast<HANDLE>(m_file));
+        m_file = nullptr;
+    }
+}
+
+#else // ifdef _WIN32
+
+CTSMappedFile::CTSMappedFile(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat info;
+
+    if ((fstat(fd, &info) != 0) || !S_ISREG(info.st_mode))
+    {
+        close(fd);
+        return;
+    }
+
+    m_size = static_cast<size_t>(info.st_size);
+
+    if (m_size == 0)
+    {
+        // Zero-length files cannot be mapped, but they are still valid input.
+        close(fd);
+        m_valid = true;
+        return;
+    }
+
+    void *addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        m_size = 0;
+        return;
+    }
+
+    madvise(addr, m_size, MADV_SEQUENTIAL);
+
+    m_data  = static_cast<const char *>(addr);
+    m_valid = true;
+}
+
+CTSMappedFile::~CTSMappedFile()
+{
+    if (m_data)
+    {
+        munmap(const_cast<char *>(m_data), m_size);
+        m_data = nullptr;
+    }
+}
+
+#endif // ifdef _WIN32
@@ -0,0 +1,503 @@
+#include "CTSMemory.h"
+#include "api.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace
+{
+// Where a block came from, and so where it goes back to when freed.
+enum BlockKind : uint8_t
+{
+    HeapBlock,
+    PooledBlock,
+    ArenaBlock
+};
+
+// Every block handed to tree-sitter is preceded by this header, which records
+// the account it was charged to, its usable size and its origin. The header is
+// padded to the strictest fundamental alignment so the block behind it keeps
+// malloc's alignment guarantees.
+struct alignas(std::max_align_t) BlockHeader
+{
+    CTSMemoryAccount *account;
+    uint64_t          size       : 48;
+    uint64_t          kind       : 8;
+    uint64_t          size_class : 8;
+};
+
+constexpr size_t   PoolGranularity = alignof(std::max_align_t);
+constexpr size_t   PoolClassCount  = CTSMemory::MaxPooledSize / PoolGranularity;
+constexpr uint32_t PoolClassDepth  = 1024;
+
+// Free lists of pooled blocks, one per size class, owned by a thread. The
+// blocks are linked through their first bytes past the header.
+struct ThreadPool
+{
+    void    *heads[PoolClassCount]  = {};
+    uint32_t counts[PoolClassCount] = {};
+
+    ThreadPool();
+    ~ThreadPool();
+
+    void Trim();
+};
+
+enum class PoolState : uint8_t
+{
+    Unused,
+    Alive,
+    Destroyed
+};
+
+std::atomic<bool>    g_installed{ false };
+std::atomic<bool>    g_pooling{ false };
+std::atomic<int64_t> g_bytes{ 0 };
+std::atomic<int64_t> g_allocations{ 0 };
+
+thread_local CTSMemoryAccount *t_current_account = nullptr;
+thread_local CTSArena         *t_current_arena   = nullptr;
+thread_local PoolState         t_pool_state      = PoolState::Unused;
+thread_local ThreadPool        t_pool;
+
+ThreadPool::ThreadPool()
+{
+    t_pool_state = PoolState::Alive;
+}
+
+ThreadPool::~ThreadPool()
+{
+    Trim();
+    t_pool_state = PoolState::Destroyed;
+}
+
+void ThreadPool::Trim()
+{
+    for (size_t idx = 0; idx < PoolClassCount; idx++)
+    {
+        while (heads[idx])
+        {
+            void *block = heads[idx];
+
+            heads[idx] = *reinterpret_cast<void **>(static_cast<BlockHeader *>(block) + 1);
+            std::free(block);
+        }
+        counts[idx] = 0;
+    }
+}
+
+// The pool of the calling thread, or nullptr once it has been torn down at
+// thread exit; blocks freed after that go straight back to the heap.
+ThreadPool* CurrentPool()
+{
+    return (t_pool_state == PoolState::Destroyed) ? nullptr : &t_pool;
+}
+
+size_t ClassCapacity(size_t size_class)
+{
+    return (size_class + 1) * PoolGranularity;
+}
+
+BlockHeader* HeaderOf(void *ptr)
+{
+    return static_cast<BlockHeader *>(ptr) - 1;
+}
+
+size_t RoundUp(size_t bytes)
+{
+    return (bytes + PoolGranularity - 1) & ~(PoolGranularity - 1);
+}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CTSMemoryAccount * CTSMemoryAccount::Create()
+{
+    return CTSMemory::IsInstalled() ? new CTSMemoryAccount() : nullptr;
+}
+
+void CTSMemoryAccount::Release()
+{
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete this;
+    }
+}
+
+void CTSMemoryAccount::Charge(size_t bytes)
+{
+    Retain();
+    m_bytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    m_allocations.fetch_add(1, std::memory_order_relaxed);
+    m_total_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CTSMemoryAccount::Credit(size_t bytes)
+{
+    m_bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    m_allocations.fetch_sub(1, std::memory_order_relaxed);
+    Release();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CTSMemoryScope::CTSMemoryScope(CTSMemoryAccount *account) : m_previous(t_current_account)
+{
+    t_current_account = account;
+}
+
+CTSMemoryScope::~CTSMemoryScope()
+{
+    t_current_account = m_previous;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CTSArena::CTSArena(size_t block_size) : m_block_size(std::max<size_t>(block_size, 4096))
+{
+}
+
+CTSArena::~CTSArena()
+{
+    for (unsigned char *block : m_blocks)
+    {
+        std::free(block);
+    }
+}
+
+void CTSArena::Merge(std::vector<std::shared_ptr<CTSArena> >      & into,
+                     const std::vector<std::shared_ptr<CTSArena> >& from)
+{
+    for (const auto& arena : from)
+    {
+        if (std::find(into.begin(), into.end(), arena) == into.end())
+        {
+            into.push_back(arena);
+        }
+    }
+}
+
+void * CTSArena::Allocate(size_t bytes)
+{
+    bytes = RoundUp(bytes);
+
+    if (bytes > static_cast<size_t>(m_end - m_next))
+    {
+        // Large requests get a block of their own, so they neither waste the
+        // tail of the current block nor force a new one.
+        const bool dedicated = bytes > m_block_size / 4;
+        const size_t size    = dedicated ? bytes : m_block_size;
+        auto *block          = static_cast<unsigned char *>(std::malloc(size));
+
+        if (!block)
+        {
+            return nullptr;
+        }
+
+        m_blocks.push_back(block);
+        m_reserved += size;
+        m_used     += bytes;
+
+        if (dedicated)
+        {
+            return block;
+        }
+
+        m_next = block;
+        m_end  = block + size;
+    }
+    else
+    {
+        m_used += bytes;
+    }
+
+    void *retval = m_next;
+
+    m_next += bytes;
+    m_last  = retval;
+    return retval;
+}
+
+bool CTSArena::TryResize(void *block, size_t old_bytes, size_t new_bytes)
+{
+    // Only the most recent allocation of the current block can grow or
+    // shrink in place.
+    if (block != m_last)
+    {
+        return false;
+    }
+
+    old_bytes = RoundUp(old_bytes);
+    new_bytes = RoundUp(new_bytes);
+
+    auto *start = static_cast<unsigned char *>(block);
+
+    if (new_bytes > static_cast<size_t>(m_end - start))
+    {
+        return false;
+    }
+
+    m_next  = start + new_bytes;
+    m_used += new_bytes;
+    m_used -= old_bytes;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+CTSArenaScope::CTSArenaScope(CTSArena *arena) : m_previous(t_current_arena)
+{
+    t_current_arena = arena;
+}
+
+CTSArenaScope::~CTSArenaScope()
+{
+    t_current_arena = m_previous;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void CTSMemory::Install(bool pool_small_blocks)
+{
+    static std::once_flag once;
+
+    std::call_once(once, [pool_small_blocks]
+                   {
+                       g_pooling = pool_small_blocks;
+                       ts_set_allocator(&CTSMemory::Malloc, &CTSMemory::Calloc,
+                                        &CTSMemory::Realloc, &CTSMemory::Free);
+                       g_installed = true;
+                   });
+}
+
+bool CTSMemory::IsInstalled()
+{
+    return g_installed.load(std::memory_order_relaxed);
+}
+
+size_t CTSMemory::TotalBytes()
+{
+    return static_cast<size_t>(g_bytes.load(std::memory_order_relaxed));
+}
+
+size_t CTSMemory::TotalAllocations()
+{
+    return static_cast<size_t>(g_allocations.load(std::memory_order_relaxed));
+}
+
+CTSMemoryAccount * CTSMemory::CurrentAccount()
+{
+    return t_current_account;
+}
+
+CTSArena * CTSMemory::CurrentArena()
+{
+    return t_current_arena;
+}
+
+size_t CTSMemory::ThreadPoolBytes()
+{
+    ThreadPool *pool = CurrentPool();
+    size_t      retval = 0;
+
+    if (pool)
+    {
+        for (size_t idx = 0; idx < PoolClassCount; idx++)
+        {
+            retval += pool->counts[idx] * (sizeof(BlockHeader) + ClassCapacity(idx));
+        }
+    }
+    return retval;
+}
+
+void CTSMemory::TrimThreadPool()
+{
+    ThreadPool *pool = CurrentPool();
+
+    if (pool)
+    {
+        pool->Trim();
+    }
+}
+
+void * CTSMemory::Allocate(size_t size, CTSMemoryAccount *account)
+{
+    BlockHeader *header = nullptr;
+    BlockKind    kind   = HeapBlock;
+    size_t       size_class = 0;
+
+    if (t_current_arena)
+    {
+        kind   = ArenaBlock;
+        header = static_cast<BlockHeader *>(t_current_arena->Allocate(sizeof(BlockHeader) + size));
+    }
+    else if ((size <= MaxPooledSize) && g_pooling.load(std::memory_order_relaxed))
+    {
+        ThreadPool *pool = CurrentPool();
+
+        kind       = PooledBlock;
+        size_class = (size == 0) ? 0 : (size - 1) / PoolGranularity;
+
+        if (pool && pool->heads[size_class])
+        {
+            header                   = static_cast<BlockHeader *>(pool->heads[size_class]);
+            pool->heads[size_class]  = *reinterpret_cast<void **>(header + 1);
+            pool->counts[size_class]--;
+        }
+        else
+        {
+            header = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + ClassCapacity(size_class)));
+        }
+    }
+    else
+    {
+        header = static_cast<BlockHeader *>(std::malloc(sizeof(BlockHeader) + size));
+    }
+
+    if (!header)
+    {
+        return nullptr;
+    }
+
+    header->account    = account;
+    header->size       = size;
+    header->kind       = kind;
+    header->size_class = size_class;
+
+    if (account)
+    {
+        account->Charge(size);
+    }
+
+    g_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    return header + 1;
+}
+
+void * CTSMemory::Malloc(size_t size)
+{
+    return Allocate(size, t_current_account);
+}
+
+void * CTSMemory::Calloc(size_t count, size_t size)
+{
+    if ((size != 0) && (count > SIZE_MAX / size))
+    {
+        return nullptr;
+    }
+
+    void *retval = Malloc(count * size);
+
+    if (retval)
+    {
+        std::memset(retval, 0, count * size);
+    }
+    return retval;
+}
+
+void * CTSMemory::Realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+    {
+        return Malloc(size);
+    }
+
+    BlockHeader *header   = HeaderOf(ptr);
+    const size_t old_size = header->size;
+
+    // A resized block stays with the account it was first charged to.
+    CTSMemoryAccount *account = header->account;
+
+    bool in_place = false;
+
+    if (header->kind == PooledBlock)
+    {
+        in_place = size <= ClassCapacity(header->size_class);
+    }
+    else if (header->kind == ArenaBlock)
+    {
+        in_place = t_current_arena &&
+                   t_current_arena->TryResize(header, sizeof(BlockHeader) + old_size, sizeof(BlockHeader) + size);
+    }
+    else
+    {
+        auto *resized = static_cast<BlockHeader *>(std::realloc(header, sizeof(BlockHeader) + size));
+
+        if (!resized)
+        {
+            return nullptr;
+        }
+
+        header   = resized;
+        in_place = true;
+    }
+
+    if (!in_place)
+    {
+        // Move the contents to a block from wherever allocations currently go.
+        void *retval = Allocate(size, account);
+
+        if (retval)
+        {
+            std::memcpy(retval, ptr, std::min(old_size, size));
+            Free(ptr);
+        }
+        return retval;
+    }
+
+    header->size = size;
+
+    if (account)
+    {
+        account->m_bytes.fetch_add(static_cast<int64_t>(size) - static_cast<int64_t>(old_size),
+                                   std::memory_order_relaxed);
+    }
+
+    g_bytes.fetch_add(static_cast<int64_t>(size) - static_cast<int64_t>(old_size),
+                      std::memory_order_relaxed);
+
+    return header + 1;
+}
+
+void CTSMemory::Free(void *ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    BlockHeader *const header = HeaderOf(ptr);
+
+    g_bytes.fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+    g_allocations.fetch_sub(1, std::memory_order_relaxed);
+
+    if (header->account)
+    {
+        header->account->Credit(header->size);
+    }
+
+    if (header->kind == ArenaBlock)
+    {
+        // Released together with the arena.
+        return;
+    }
+
+    if (header->kind == PooledBlock)
+    {
+        ThreadPool  *pool       = CurrentPool();
+        const size_t size_class = header->size_class;
+
+        if (pool && (pool->counts[size_class] < PoolClassDepth))
+        {
+            *reinterpret_cast<void **>(ptr) = pool->heads[size_class];
+            pool->heads[size_class]         = header;
+            pool->counts[size_class]++;
+            return;
+        }
+    }
+
+    std::free(header);
+}
@@ -0,0 +1,188 @@
+#include "CTSMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+void AppendCounter(std::string& out, std::string_view name, std::string_view help, uint64_t value)
+{
+    out.append("# HELP tswrapper_").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE tswrapper_").append(name).append(" counter\n");
+    out.append("tswrapper_").append(name).append(" ").append(std::to_string(value)).append("\n");
+}
+
+std::string FormatBound(double value)
+{
+    char buffer[32];
+
+    std::snprintf(buffer, sizeof(buffer), "%g", value);
+    return buffer;
+}
+
+double Micros(std::chrono::nanoseconds duration)
+{
+    return static_cast<double>(duration.count()) / 1000.0;
+}
+}
+
+CTSHistogram::CTSHistogram(std::vector<double> bounds) :
+    m_bounds(std::move(bounds)),
+    m_buckets(m_bounds.size() + 1)
+{
+    std::sort(m_bounds.begin(), m_bounds.end());
+}
+
+std::vector<double> CTSHistogram::ExponentialBounds(double max)
+{
+    std::vector<double> retval;
+
+    for (double bound = 1.0; ; bound *= 2.0)
+    {
+        retval.push_back(bound);
+
+        if (bound >= max)
+        {
+            break;
+        }
+    }
+    return retval;
+}
+
+void CTSHistogram::Record(double value)
+{
+    const size_t bucket = std::lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum_micro.fetch_add(static_cast<uint64_t>(std::max(0.0, value) * 1e6), std::memory_order_relaxed);
+}
+
+double CTSHistogram::Sum() const
+{
+    return static_cast<double>(m_sum_micro.load(std::memory_order_relaxed)) / 1e6;
+}
+
+double CTSHistogram::Quantile(double quantile) const
+{
+    const uint64_t count = Count();
+
+    if (count == 0)
+    {
+        return 0.0;
+    }
+
+    const uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * count));
+    uint64_t       seen = 0;
+
+    for (size_t i = 0; i < m_bounds.size(); i++)
+    {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+
+        if (seen >= std::max<uint64_t>(rank, 1))
+        {
+            return m_bounds[i];
+        }
+    }
+    return m_bounds.empty() ? HUGE_VAL : m_bounds.back();
+}
+
+void CTSHistogram::Export(std::string& out, std::string_view name, std::string_view help) const
+{
+    out.append("# HELP tswrapper_").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE tswrapper_").append(name).append(" histogram\n");
+
+    // Buckets are exported cumulatively, as the format requires.
+    uint64_t cumulative = 0;
+
+    for (size_t i = 0; i <= m_bounds.size(); i++)
+    {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+
+        const std::string le = (i < m_bounds.size()) ? FormatBound(m_bounds[i]) : "+Inf";
+
+        out.append("tswrapper_").append(name).append("_bucket{le=\"").append(le).append("\"} ");
+        out.append(std::to_string(cumulative)).append("\n");
+    }
+    out.append("tswrapper_").append(name).append("_sum ").append(FormatBound(Sum())).append("\n");
+    out.append("tswrapper_").append(name).append("_count ").append(std::to_string(cumulative)).append("\n");
+}
+
+CTSMetricsRegistry::CTSMetricsRegistry(bool node_counts) :
+    m_node_counts(node_counts),
+    m_parse_duration(CTSHistogram::ExponentialBounds(1 << 24)),
+    m_query_duration(CTSHistogram::ExponentialBounds(1 << 24)),
+    m_reuse_percent({ 0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 95, 99, 100 })
+{
+}
+
+void CTSMetricsRegistry::OnParse(const CTSParseStats& stats)
+{
+    m_parses.fetch_add(1, std::memory_order_relaxed);
+
+    if (!stats.succeeded)
+    {
+        m_failed_parses.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_parsed_bytes.fetch_add(stats.bytes, std::memory_order_relaxed);
+    m_parse_duration.Record(Micros(stats.wall_time));
+
+    if (stats.has_error)
+    {
+        m_trees_with_errors.fetch_add(1, std::memory_order_relaxed);
+        m_error_nodes.fetch_add(stats.error_node_count, std::memory_order_relaxed);
+        m_missing_nodes.fetch_add(stats.missing_node_count, std::memory_order_relaxed);
+    }
+
+    if (stats.incremental)
+    {
+        m_incremental_parses.fetch_add(1, std::memory_order_relaxed);
+
+        if (stats.node_count)
+        {
+            m_reuse_percent.Record(stats.ReuseRatio() * 100.0);
+        }
+    }
+}
+
+void CTSMetricsRegistry::OnQuery(const CTSQueryStats& stats)
+{
+    m_queries.fetch_add(1, std::memory_order_relaxed);
+    m_query_steps.fetch_add(stats.steps, std::memory_order_relaxed);
+    m_query_matches.fetch_add(stats.matches, std::memory_order_relaxed);
+    m_query_captures.fetch_add(stats.captures, std::memory_order_relaxed);
+    m_predicate_rejections.fetch_add(stats.predicate_rejections, std::memory_order_relaxed);
+
+    if (stats.exceeded_match_limit)
+    {
+        m_match_limit_exceeded.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_query_duration.Record(Micros(stats.wall_time));
+}
+
+std::string CTSMetricsRegistry::ExportText() const
+{
+    std::string retval;
+
+    AppendCounter(retval, "parses_total", "Parses run, including failed ones.", Parses());
+    AppendCounter(retval, "incremental_parses_total", "Parses that reused an old tree.", IncrementalParses());
+    AppendCounter(retval, "failed_parses_total", "Parses that produced no tree.", FailedParses());
+    AppendCounter(retval, "parsed_bytes_total", "Bytes of source parsed.", ParsedBytes());
+    AppendCounter(retval, "trees_with_errors_total", "Parses whose tree contains syntax errors.", TreesWithErrors());
+    AppendCounter(retval, "error_nodes_total", "ERROR nodes in parsed trees.", ErrorNodes());
+    AppendCounter(retval, "missing_nodes_total", "MISSING nodes in parsed trees.", MissingNodes());
+    m_parse_duration.Export(retval, "parse_duration_microseconds", "Time spent parsing.");
+    m_reuse_percent.Export(retval, "parse_reuse_percent", "Share of nodes reused by incremental parses.");
+
+    AppendCounter(retval, "queries_total", "Query executions.", Queries());
+    AppendCounter(retval, "query_steps_total", "Query cursor advances.", QuerySteps());
+    AppendCounter(retval, "query_matches_total", "Query matches returned.", QueryMatches());
+    AppendCounter(retval, "query_captures_total", "Query captures returned.", QueryCaptures());
+    AppendCounter(retval, "query_predicate_rejections_total", "Query matches dropped by predicates.", PredicateRejections());
+    AppendCounter(retval, "query_match_limit_exceeded_total", "Query executions that hit the match limit.", MatchLimitExceeded());
+    m_query_duration.Export(retval, "query_duration_microseconds", "Time spent executing queries.");
+    return retval;
+}
@@ -1,6 +1,7 @@
 //#include "pch.h"
 // ReSharper disable CppClangTidyClangDiagnosticShorten64To32
 #include "CTSNode.h"
+#include "alloc.h"
 
 CTSNode::CTSNode() : TSNode()
 {
@@ -20,6 +21,7 @@ CTSNode::CTSNode(TSNode node) : TSNode()
 
 
 std::string CTSNode::Type() const { return { ts_node_type(*this) }; }
+std::string_view CTSNode::TypeView() const { return { ts_node_type(*this) }; }
 
 TSSymbol CTSNode::Symbol() const { return ts_node_symbol(*this); }
 
@@ -32,7 +34,8 @@ std::string CTSNode::String() const
 {
 	char* free_me_after_use = ts_node_string(*this);
 	auto retval = std::string(free_me_after_use);
-	free(free_me_after_use);
+	// The string comes from tree-sitter's allocator, which may be CTSMemory's.
+	ts_current_free(free_me_after_use);
 	return retval;
 }
 
@@ -58,6 +61,13 @@ std::string CTSNode::FieldNameForChild(uint32_t index, bool* was_found) const
 	if (s) return {s}; else return {};
 }
 
+std::string_view CTSNode::FieldNameViewForChild(uint32_t index, bool* was_found) const
+{
+	auto s = ts_node_field_name_for_child(*this, index);
+	if (was_found) { *was_found = (s != nullptr); }
+	if (s) return {s}; else return {};
+}
+
 uint32_t CTSNode::ChildCount() const { return ts_node_child_count(*this); }
 uint32_t CTSNode::NamedChildCount() const { return ts_node_named_child_count(*this); }
 
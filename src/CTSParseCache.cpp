@@ -0,0 +1,199 @@
+#include "CTSParseCache.h"
+#include "CTSContentHash.h"
+
+#include <cstdio>
+#include <vector>
+
+CTSParseCache::CTSParseCache(size_t max_bytes, std::string disk_directory) :
+    m_max_bytes(max_bytes),
+    m_disk_directory(std::move(disk_directory))
+{
+}
+
+CTSParseCache::Key CTSParseCache::MakeKey(const CTSParser& parser, std::string_view source)
+{
+    const std::vector<TSRange> ranges = parser.IncludedRanges();
+
+    Key retval;
+
+    retval.language = parser.Language()->Fingerprint();
+    retval.ranges   = CTSContentHash({ reinterpret_cast<const char *>(ranges.data()), ranges.size() * sizeof(TSRange) });
+    retval.content  = CTSContentHash(source);
+    retval.length   = source.size();
+    return retval;
+}
+
+std::string CTSParseCache::DiskPath(const Key& key) const
+{
+    // The file header only records the content hash, so the length goes
+    // into the name to identify content as strictly as the memory tier does.
+    char name[96];
+
+    std::snprintf(name, sizeof(name), "%016llx-%016llx-%016llx-%016llx.ctsflat",
+                  static_cast<unsigned long long>(key.language),
+                  static_cast<unsigned long long>(key.ranges),
+                  static_cast<unsigned long long>(key.content),
+                  static_cast<unsigned long long>(key.length));
+
+    return m_disk_directory + "/" + name;
+}
+
+std::shared_ptr<CTSTree>CTSParseCache::Lookup(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto                  found = m_index.find(key);
+
+    if (found == m_index.end())
+    {
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    m_stats.hits++;
+
+    const auto& tree = found->second->tree;
+
+    return tree->Copy(tree.get());
+}
+
+std::shared_ptr<CTSTree>CTSParseCache::Find(const CTSParser& parser, std::string_view source)
+{
+    return Lookup(MakeKey(parser, source));
+}
+
+std::shared_ptr<CTSTree>CTSParseCache::Parse(const CTSParser& parser, std::string_view source)
+{
+    const Key key = MakeKey(parser, source);
+
+    if (auto retval = Lookup(key))
+    {
+        return retval;
+    }
+
+    auto tree = parser.ParseString(source);
+
+    if (!tree)
+    {
+        return nullptr;
+    }
+
+    // Measured outside the lock: this walks the whole tree.
+    const CTSTreeMemoryUsage usage = tree->MemoryUsage();
+    const size_t             bytes = usage.tracked_bytes ? usage.tracked_bytes : usage.estimated_bytes;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_stats.parses++;
+
+    // Another thread may have parsed the same content in the meantime; keep
+    // the first tree so that every caller shares one set of nodes.
+    const auto found = m_index.find(key);
+
+    if (found != m_index.end())
+    {
+        const auto& cached = found->second->tree;
+        return cached->Copy(cached.get());
+    }
+
+    if (bytes > m_max_bytes)
+    {
+        return tree;
+    }
+
+    m_entries.push_front({ key, tree, bytes });
+    m_index.emplace(key, m_entries.begin());
+    m_bytes += bytes;
+    EvictLocked();
+
+    return tree->Copy(tree.get());
+}
+
+std::shared_ptr<CTSFlatTree>CTSParseCache::ParseFlat(const CTSParser& parser, std::string_view source)
+{
+    const Key key = MakeKey(parser, source);
+
+    if (!m_disk_directory.empty())
+    {
+        if (auto retval = CTSFlatTree::Load(DiskPath(key), *parser.Language(), key.content))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.disk_hits++;
+            return retval;
+        }
+    }
+
+    const auto tree = Parse(parser, source);
+
+    if (!tree)
+    {
+        return nullptr;
+    }
+
+    auto retval = std::make_shared<CTSFlatTree>(tree);
+
+    if (!m_disk_directory.empty() && retval->Save(DiskPath(key), key.content))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.disk_writes++;
+    }
+    return retval;
+}
+
+void CTSParseCache::EvictLocked()
+{
+    while ((m_bytes > m_max_bytes) && !m_entries.empty())
+    {
+        const Entry& entry = m_entries.back();
+
+        m_bytes -= entry.bytes;
+        m_index.erase(entry.key);
+        m_entries.pop_back();
+        m_stats.evictions++;
+    }
+}
+
+size_t CTSParseCache::Bytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_bytes;
+}
+
+size_t CTSParseCache::MaxBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_max_bytes;
+}
+
+void CTSParseCache::SetMaxBytes(size_t max_bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_max_bytes = max_bytes;
+    EvictLocked();
+}
+
+size_t CTSParseCache::Size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_entries.size();
+}
+
+void CTSParseCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_index.clear();
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+CTSParseCacheStats CTSParseCache::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_stats;
+}
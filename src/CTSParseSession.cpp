@@ -0,0 +1,15 @@
+#include "CTSParseSession.h"
+
+CTSParseSession::CTSParseSession(const TSLanguage *language, size_t arena_block_size) :
+    m_language(language),
+    m_block_size(arena_block_size)
+{
+    Reset();
+}
+
+void CTSParseSession::Reset()
+{
+    m_parser.reset();
+    m_arena  = std::make_shared<CTSArena>(m_block_size);
+    m_parser = std::make_unique<CTSParser>(m_language, m_arena);
+}
@@ -0,0 +1,196 @@
+#include "CTSParseTask.h"
+
+#include <algorithm>
+
+CTSParseTask::CTSParseTask(const CTSParser       & parser,
+                           std::string_view        text,
+                           std::shared_ptr<CTSTree>old_tree,
+                           CTSCancellationToken    token,
+                           std::string_view        path) :
+    m_parser(parser),
+    m_text(text),
+    m_path(path),
+    m_old_tree(std::move(old_tree)),
+    m_token(std::move(token))
+{
+    if (m_text.size() > UINT32_MAX)
+    {
+        m_status = CTSParseStatus::Failed;
+    }
+}
+
+CTSParseTask::CTSParseTask(const CTSParser       & parser,
+                           CTSInputSource        & source,
+                           std::shared_ptr<CTSTree>old_tree,
+                           CTSCancellationToken    token) :
+    m_parser(parser),
+    m_source(&source),
+    m_source_input(source.GetTSInput()),
+    m_old_tree(std::move(old_tree)),
+    m_token(std::move(token))
+{
+}
+
+CTSParseTask::~CTSParseTask()
+{
+    if (m_status == CTSParseStatus::Suspended)
+    {
+        m_parser.Reset();
+        Record();
+    }
+
+    if (m_account)
+    {
+        m_account->Release();
+    }
+}
+
+CTSParseStatus CTSParseTask::RunUntil(Clock::time_point deadline)
+{
+    if (IsFinished())
+    {
+        return m_status;
+    }
+
+    if (!m_parser.LanguageSetResult())
+    {
+        return Finish(CTSParseStatus::Failed);
+    }
+
+    if (m_token.IsCancelRequested())
+    {
+        return Finish(CTSParseStatus::Cancelled);
+    }
+
+    const Clock::time_point limit = std::min(deadline, m_token.Deadline());
+    const Clock::time_point now   = Clock::now();
+
+    if (limit <= now)
+    {
+        if (m_token.HasDeadline() && (m_token.Deadline() <= now))
+        {
+            return Finish(CTSParseStatus::DeadlineExceeded);
+        }
+        m_status = CTSParseStatus::Suspended;
+        return m_status;
+    }
+
+    // A timeout of zero means no timeout to tree-sitter, so round up.
+    uint64_t timeout = 0;
+
+    if (limit != Clock::time_point::max())
+    {
+        timeout = std::max<uint64_t>(1, std::chrono::duration_cast<std::chrono::microseconds>(limit - now).count());
+    }
+
+    const uint64_t saved_timeout = m_parser.TimeoutMicros();
+    const size_t  *saved_flag    = m_parser.CancellationFlag();
+
+    m_parser.SetTimeoutMicros(timeout);
+    m_parser.SetCancellationFlag(m_token.Flag());
+    m_slices++;
+
+    const TSInput input = { this, &CTSParseTask::Read, m_source ? m_source_input.encoding : TSInputEncodingUTF8 };
+
+    if (!m_account)
+    {
+        m_account = CTSMemoryAccount::Create();
+    }
+
+    // The parse takes over a reference of its own.
+    if (m_account)
+    {
+        m_account->Retain();
+    }
+
+    auto tree = m_parser.ParseUnrecorded(m_old_tree, input, m_account);
+
+    m_wall_time += Clock::now() - now;
+    m_parser.SetTimeoutMicros(saved_timeout);
+    m_parser.SetCancellationFlag(saved_flag);
+
+    if (tree)
+    {
+        m_tree = std::move(tree);
+        Record();
+        m_status   = CTSParseStatus::Completed;
+        m_old_tree = nullptr;
+        return m_status;
+    }
+
+    if (m_token.IsCancelRequested())
+    {
+        return Finish(CTSParseStatus::Cancelled);
+    }
+
+    if (timeout == 0)
+    {
+        return Finish(CTSParseStatus::Failed);
+    }
+
+    if (m_token.HasDeadline() && (Clock::now() >= m_token.Deadline()))
+    {
+        return Finish(CTSParseStatus::DeadlineExceeded);
+    }
+
+    m_status = CTSParseStatus::Suspended;
+    return m_status;
+}
+
+CTSParseStatus CTSParseTask::Finish(CTSParseStatus status)
+{
+    // Drop the halted parse so the parser starts afresh next time.
+    if (m_slices > 0)
+    {
+        m_parser.Reset();
+        Record();
+    }
+
+    m_status   = status;
+    m_old_tree = nullptr;
+    return m_status;
+}
+
+void CTSParseTask::Record() const
+{
+    // One report for the whole parse, however many slices it took.
+    if (m_parser.m_metrics)
+    {
+        m_parser.m_metrics_path = m_path;
+        m_parser.RecordParse(m_old_tree, m_tree, m_source ? m_bytes_consumed : TotalBytes(), m_wall_time);
+        m_parser.m_metrics_path = {};
+    }
+}
+
+const char * CTSParseTask::Read(void *payload, uint32_t byte, TSPoint point, uint32_t *bytes_read)
+{
+    auto *self = static_cast<CTSParseTask *>(payload);
+
+    const char *retval = nullptr;
+    uint32_t    length = 0;
+
+    if (self->m_source)
+    {
+        retval = self->m_source_input.read(self->m_source_input.payload, byte, point, &length);
+    }
+    else if (byte < self->m_text.size())
+    {
+        // Bounded chunks make the parser come back for more text regularly,
+        // which is what lets progress be observed.
+        retval = self->m_text.data() + byte;
+        length = std::min<uint32_t>(ProgressChunkSize, static_cast<uint32_t>(self->m_text.size()) - byte);
+    }
+
+    if (retval && (length > 0) && (byte + length > self->m_bytes_consumed))
+    {
+        self->m_bytes_consumed = byte + length;
+
+        if (self->m_progress)
+        {
+            self->m_progress(self->m_bytes_consumed);
+        }
+    }
+
+    *bytes_read = retval ? length : 0;
+    return retval ? retval : "";
+}
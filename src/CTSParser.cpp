@@ -1,11 +1,54 @@
 // ReSharper disable CppClangTidyClangDiagnosticShorten64To32
 #include "CTSParser.h"
+#include "CTSMappedFile.h"
+#include "CTSSymbolTable.h"
+#include "CTSTreeWalker.h"
+
+#include <algorithm>
 
 using namespace std;
 
+namespace
+{
+// Forwards reads to another input while noting how far into it the parser
+// has read, which is what a parse from a TSInput reports as its size.
+struct MeasuredInput
+{
+    TSInput  input;
+    uint32_t furthest = 0;
+
+    static const char* Read(void *payload, uint32_t byte, TSPoint point, uint32_t *bytes_read)
+    {
+        auto *self = static_cast<MeasuredInput *>(payload);
+
+        const char *retval = self->input.read(self->input.payload, byte, point, bytes_read);
+
+        if (retval && (*bytes_read > 0))
+        {
+            self->furthest = std::max(self->furthest, byte + *bytes_read);
+        }
+        return retval;
+    }
+};
+}
 
-CTSParser::CTSParser(const TSLanguage *language) : m_lang(nullptr)
+
+CTSParser::CTSParser(const TSLanguage *language) : CTSParser(language, nullptr)
+{
+}
+
+CTSParser::CTSParser(const TSLanguage *language, std::shared_ptr<CTSArena>arena) : m_lang(nullptr), m_arena(std::move(arena))
 {
+    m_account = CTSMemoryAccount::Create();
+
+    if (m_arena)
+    {
+        m_arenas.push_back(m_arena);
+    }
+
+    const CTSMemoryScope scope(m_account);
+    const CTSArenaScope  arena_scope(m_arena.get());
+
     m_self            = ts_parser_new();
     m_set_lang_result = SetLanguage(language);
 }
@@ -23,6 +66,12 @@ CTSParser::~CTSParser()
         delete m_lang;
         m_lang = nullptr;
     }
+
+    if (m_account)
+    {
+        m_account->Release();
+        m_account = nullptr;
+    }
 }
 
 bool CTSParser::SetLanguage(const TSLanguage *language)
@@ -43,6 +92,9 @@ bool CTSParser::SetIncludedRanges(std::vector<TSRange>ranges) const
 {
     const TSRange *items = ranges.data();
 
+    const CTSMemoryScope scope(m_account);
+    const CTSArenaScope  arena_scope(m_arena.get());
+
     return ts_parser_set_included_ranges(m_self, items, static_cast<uint32_t>(ranges.size()));
 }
 
@@ -59,34 +111,274 @@ std::vector<TSRange>CTSParser::IncludedRanges() const
     return retval;
 }
 
-std::shared_ptr<CTSTree>CTSParser::Parse(const std::shared_ptr<CTSTree>& /*old_tree*/,
-                                         TSInput input) const
+std::shared_ptr<CTSTree>CTSParser::Parse(const std::shared_ptr<CTSTree>& old_tree,
+                                         TSInput                         input) const
+{
+    if (!m_metrics)
+    {
+        return ParseUnrecorded(old_tree, input);
+    }
+
+    MeasuredInput measured = { input };
+
+    const auto start  = std::chrono::steady_clock::now();
+    auto       retval = ParseUnrecorded(old_tree, { &measured, &MeasuredInput::Read, input.encoding });
+
+    RecordParse(old_tree, retval, measured.furthest, std::chrono::steady_clock::now() - start);
+    return retval;
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseUnrecorded(const std::shared_ptr<CTSTree>& old_tree,
+                                                   TSInput                         input) const
+{
+    return ParseUnrecorded(old_tree, input, CTSMemoryAccount::Create());
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseUnrecorded(const std::shared_ptr<CTSTree>& old_tree,
+                                                   TSInput                         input,
+                                                   CTSMemoryAccount               *account) const
 {
-    return std::make_shared<CTSTree>(ts_parser_parse(m_self,
-                                                     /*old_tree->GetEncapsulatedTSTree()*/ nullptr,
-                                                     input));
+    TSTree *tree = nullptr;
+
+    RetainArenas(old_tree);
+
+    {
+        const CTSMemoryScope scope(account);
+        const CTSArenaScope  arena_scope(m_arena.get());
+        tree = ts_parser_parse(m_self, old_tree ? old_tree->m_tree : nullptr, input);
+    }
+    return WrapTree(tree, account);
 }
 
 std::shared_ptr<CTSTree>CTSParser::Parse(TSInput input) const
 {
-    return std::make_shared<CTSTree>(ts_parser_parse(m_self, nullptr, input));
+    return Parse(nullptr, input);
 }
 
-std::shared_ptr<CTSTree>CTSParser::ParseString(const std::string& str) const
+std::shared_ptr<CTSTree>CTSParser::Parse(const std::shared_ptr<CTSTree>& old_tree,
+                                         CTSInputSource                & source) const
 {
-    return std::make_shared<CTSTree>(ts_parser_parse_string(m_self,
-                                                            nullptr,
-                                                            str.c_str(),
-                                                            static_cast<uint32_t>(str.length())));
+    return Parse(old_tree, source.GetTSInput());
+}
+
+std::shared_ptr<CTSTree>CTSParser::Parse(CTSInputSource& source) const
+{
+    return Parse(nullptr, source.GetTSInput());
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseString(std::string_view str) const
+{
+    return ParseString(nullptr, str);
 }
 
 std::shared_ptr<CTSTree>CTSParser::ParseString(const std::shared_ptr<CTSTree>& old_tree,
-                                               const std::string             & str) const
+                                               std::string_view                str) const
+{
+    // tree-sitter measures input in 32-bit offsets.
+    if (str.size() > UINT32_MAX)
+    {
+        return nullptr;
+    }
+
+    return ParseString(old_tree, str.data(), static_cast<uint32_t>(str.length()));
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseString(const char *str, uint32_t length) const
 {
-    return make_shared<CTSTree>(ts_parser_parse_string(m_self,
-                                                       old_tree->m_tree,
-                                                       str.c_str(),
-                                                       static_cast<uint32_t>(str.length())));
+    return ParseString(nullptr, str, length);
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseString(const std::shared_ptr<CTSTree>& old_tree,
+                                               const char                     *str,
+                                               uint32_t                        length) const
+{
+    CTSMemoryAccount *account = CTSMemoryAccount::Create();
+    TSTree           *tree    = nullptr;
+
+    RetainArenas(old_tree);
+
+    const auto start = m_metrics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    {
+        const CTSMemoryScope scope(account);
+        const CTSArenaScope  arena_scope(m_arena.get());
+        tree = ts_parser_parse_string(m_self, old_tree ? old_tree->m_tree : nullptr, str, length);
+    }
+
+    auto retval = WrapTree(tree, account);
+
+    if (m_metrics)
+    {
+        RecordParse(old_tree, retval, length, std::chrono::steady_clock::now() - start);
+    }
+    return retval;
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseFile(const std::string& path) const
+{
+    return ParseFile(nullptr, path);
+}
+
+std::shared_ptr<CTSTree>CTSParser::ParseFile(const std::shared_ptr<CTSTree>& old_tree,
+                                             const std::string             & path) const
+{
+    const CTSMappedFile file(path);
+
+    if (!file.IsValid() || (file.Size() > UINT32_MAX))
+    {
+        return nullptr;
+    }
+
+    // The tree does not refer back to the source text, so the mapping can be
+    // released as soon as the parse is done.
+    m_metrics_path = path;
+
+    auto retval = ParseString(old_tree, file.Data(), static_cast<uint32_t>(file.Size()));
+
+    m_metrics_path = {};
+    return retval;
+}
+
+std::shared_ptr<CTSTree>CTSParser::Reparse(const std::shared_ptr<CTSTree>& old_tree,
+                                           const std::vector<TSInputEdit>& edits,
+                                           TSInput                         input,
+                                           std::vector<TSRange>           *changed_ranges) const
+{
+    if (old_tree)
+    {
+        old_tree->Edit(edits);
+    }
+
+    auto retval = Parse(old_tree, input);
+
+    FillChangedRanges(old_tree, retval, changed_ranges);
+    return retval;
+}
+
+std::shared_ptr<CTSTree>CTSParser::ReparseString(const std::shared_ptr<CTSTree>& old_tree,
+                                                 const std::vector<TSInputEdit>& edits,
+                                                 std::string_view                str,
+                                                 std::vector<TSRange>           *changed_ranges) const
+{
+    if (old_tree)
+    {
+        old_tree->Edit(edits);
+    }
+
+    auto retval = ParseString(old_tree, str);
+
+    FillChangedRanges(old_tree, retval, changed_ranges);
+    return retval;
+}
+
+void CTSParser::RetainArenas(const std::shared_ptr<CTSTree>& old_tree) const
+{
+    // Reparsing recycles nodes of the old tree through the parser's pools, so
+    // from now on the parser and its trees depend on the old tree's arenas.
+    if (old_tree)
+    {
+        CTSArena::Merge(m_arenas, old_tree->m_arenas);
+    }
+}
+
+void CTSParser::RecordParse(const std::shared_ptr<CTSTree>& old_tree,
+                            const std::shared_ptr<CTSTree>& new_tree,
+                            uint32_t                        bytes,
+                            std::chrono::nanoseconds        wall_time) const
+{
+    auto stats = std::make_shared<CTSParseStats>();
+
+    stats->wall_time   = wall_time;
+    stats->incremental = old_tree != nullptr;
+    stats->succeeded   = new_tree != nullptr;
+    stats->bytes       = bytes;
+
+    if (new_tree)
+    {
+        const CTSNode root = new_tree->RootNode();
+
+        stats->has_error = root.HasError();
+
+        if (m_metrics->WantsNodeCounts())
+        {
+            const CTSTreeMemoryUsage usage = new_tree->MemoryUsage(old_tree.get());
+
+            stats->node_count        = usage.node_count;
+            stats->reused_node_count = usage.shared_node_count;
+
+            // Only subtrees flagged as containing errors need to be visited.
+            if (stats->has_error)
+            {
+                CTSTreeWalker::Walk(root,
+                                    [&](const CTSTreeCursor& cursor, uint32_t)
+                                    {
+                                        const CTSNode node = cursor.CurrentNode();
+
+                                        if (node.IsMissing())
+                                        {
+                                            stats->missing_node_count++;
+                                        }
+                                        else if (node.Symbol() == CTSErrorSymbol)
+                                        {
+                                            stats->error_node_count++;
+                                        }
+                                        return node.HasError() ? CTSVisitAction::Continue : CTSVisitAction::SkipChildren;
+                                    },
+                                    [](const CTSTreeCursor&, uint32_t) {});
+            }
+        }
+        new_tree->m_parse_stats = stats;
+    }
+
+    // The path is only reported to the sink; the copy kept on the tree would
+    // outlive the string it refers to.
+    CTSParseStats report = *stats;
+
+    report.path = m_metrics_path;
+    m_metrics->OnParse(report);
+}
+
+std::shared_ptr<CTSTree>CTSParser::WrapTree(TSTree *tree, CTSMemoryAccount *account) const
+{
+    if (!tree)
+    {
+        if (account)
+        {
+            account->Release();
+        }
+        return nullptr;
+    }
+
+    auto retval = std::make_shared<CTSTree>(tree);
+
+    retval->m_account = account;
+    retval->m_arenas  = m_arenas;
+    return retval;
+}
+
+void CTSParser::FillChangedRanges(const std::shared_ptr<CTSTree>& old_tree,
+                                  const std::shared_ptr<CTSTree>& new_tree,
+                                  std::vector<TSRange>           *changed_ranges)
+{
+    if (!changed_ranges)
+    {
+        return;
+    }
+
+    changed_ranges->clear();
+
+    if (old_tree && new_tree)
+    {
+        *changed_ranges = old_tree->GetChangedRanges(new_tree);
+    }
+    else if (new_tree)
+    {
+        // Without an old tree there is nothing to compare against, so the
+        // whole document counts as changed.
+        const CTSNode root = new_tree->RootNode();
+        changed_ranges->push_back({ root.StartPoint(), root.EndPoint(),
+                                    root.StartByte(), root.EndByte() });
+    }
 }
 
 #ifdef HANDLE_UTF
@@ -1,23 +1,317 @@
 // ReSharper disable CppClangTidyClangDiagnosticShorten64To32
 #include "CTSQuery.h"
+#include "CTSContentHash.h"
 #include "CTSLanguage.h"
 
-CTSQuery::CTSQuery(const CTSLanguage* lang, const char* oldstr)
+#include <cctype>
+
+namespace
+{
+// A minimal reader for the head of each pattern in a query's source, enough
+// to tell which node types the pattern can start at. The source has already
+// been accepted by tree-sitter, so it is known to be well formed.
+
+bool IsDelimiter(char c)
+{
+	return std::isspace(static_cast<unsigned char>(c)) || (c == '(') || (c == ')') || (c == '[') ||
+		(c == ']') || (c == '"') || (c == ';');
+}
+
+void SkipSpace(std::string_view source, size_t& pos)
+{
+	while (pos < source.size())
+	{
+		if (source[pos] == ';')
+		{
+			while ((pos < source.size()) && (source[pos] != '\n'))
+			{
+				pos++;
+			}
+		}
+		else if (std::isspace(static_cast<unsigned char>(source[pos])))
+		{
+			pos++;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+std::string ReadString(std::string_view source, size_t& pos)
+{
+	std::string retval;
+
+	for (pos++; (pos < source.size()) && (source[pos] != '"'); pos++)
+	{
+		if ((source[pos] == '\\') && (pos + 1 < source.size()))
+		{
+			switch (source[++pos])
+			{
+			case 'n': retval.push_back('\n'); break;
+			case 'r': retval.push_back('\r'); break;
+			case 't': retval.push_back('\t'); break;
+			case '0': retval.push_back('\0'); break;
+			default: retval.push_back(source[pos]); break;
+			}
+		}
+		else
+		{
+			retval.push_back(source[pos]);
+		}
+	}
+	pos++;
+	return retval;
+}
+
+std::string_view ReadToken(std::string_view source, size_t& pos)
+{
+	const size_t start = pos;
+
+	while ((pos < source.size()) && !IsDelimiter(source[pos]))
+	{
+		pos++;
+	}
+	return source.substr(start, pos - start);
+}
+
+// Skip one element: a parenthesized or bracketed group, a string or a token.
+void SkipElement(std::string_view source, size_t& pos)
+{
+	if (pos >= source.size())
+	{
+		return;
+	}
+
+	if (source[pos] == '"')
+	{
+		ReadString(source, pos);
+		return;
+	}
+
+	if ((source[pos] != '(') && (source[pos] != '['))
+	{
+		ReadToken(source, pos);
+		return;
+	}
+
+	uint32_t depth = 0;
+
+	while (pos < source.size())
+	{
+		const char c = source[pos];
+
+		if (c == '"')
+		{
+			ReadString(source, pos);
+			continue;
+		}
+
+		if (c == ';')
+		{
+			SkipSpace(source, pos);
+			continue;
+		}
+
+		pos++;
+
+		if ((c == '(') || (c == '['))
+		{
+			depth++;
+		}
+		else if (((c == ')') || (c == ']')) && (--depth == 0))
+		{
+			return;
+		}
+	}
+}
+
+// Resolves node type names to symbols, through the tables of a CTSLanguage
+// when the caller has one, otherwise straight from the language, so that
+// compiling a query never builds the tables just for this.
+struct RootNames
+{
+	const TSLanguage*  language;
+	const CTSLanguage* tables;
+
+	// Add every symbol called name to roots. Returns false if there is none.
+	bool Insert(std::string_view name, CTSSymbolSet& roots) const
+	{
+		if (tables)
+		{
+			const std::vector<TSSymbol> symbols = tables->SymbolsForName(name);
+
+			for (const TSSymbol symbol : symbols)
+			{
+				roots.Insert(symbol);
+			}
+			return !symbols.empty();
+		}
+
+		bool found = false;
+		const uint32_t count = ts_language_symbol_count(language);
+
+		for (uint32_t idx = 0; idx < count; idx++)
+		{
+			const char* symbol_name = ts_language_symbol_name(language, static_cast<TSSymbol>(idx));
+
+			if (symbol_name && (name == symbol_name))
+			{
+				roots.Insert(static_cast<TSSymbol>(idx));
+				found = true;
+			}
+		}
+
+		// Built-in symbols such as ERROR are outside the table, but the
+		// library still resolves them by name.
+		if (!found)
+		{
+			for (const bool is_named : { true, false })
+			{
+				const TSSymbol symbol = ts_language_symbol_for_name(language, name.data(),
+					static_cast<uint32_t>(name.length()), is_named);
+
+				if (symbol != 0)
+				{
+					roots.Insert(symbol);
+					found = true;
+				}
+			}
+		}
+		return found;
+	}
+};
+
+// Add the symbols the pattern element at pos can start at to roots. Returns
+// false if it can start at any node.
+bool CollectRoots(std::string_view source, size_t pos, const RootNames& names, CTSSymbolSet& roots)
+{
+	SkipSpace(source, pos);
+
+	if (pos >= source.size())
+	{
+		return false;
+	}
+
+	if (source[pos] == '"')
+	{
+		return names.Insert(ReadString(source, pos), roots);
+	}
+
+	if (source[pos] == '[')
+	{
+		// Every alternative is a possible start.
+		for (pos++; ; )
+		{
+			SkipSpace(source, pos);
+
+			if ((pos >= source.size()) || (source[pos] == ']'))
+			{
+				return true;
+			}
+
+			const char c = source[pos];
+
+			if ((c == '(') || (c == '[') || (c == '"'))
+			{
+				if (!CollectRoots(source, pos, names, roots))
+				{
+					return false;
+				}
+				SkipElement(source, pos);
+			}
+			else if ((c == '@') || (c == '*') || (c == '+') || (c == '?'))
+			{
+				ReadToken(source, pos);
+			}
+			else
+			{
+				return false;
+			}
+		}
+	}
+
+	if (source[pos] != '(')
+	{
+		return false;
+	}
+
+	pos++;
+	SkipSpace(source, pos);
+
+	if (pos >= source.size())
+	{
+		return false;
+	}
+
+	// A group of one pattern and its predicates starts where the pattern does.
+	if ((source[pos] == '(') || (source[pos] == '[') || (source[pos] == '"'))
+	{
+		return CollectRoots(source, pos, names, roots);
+	}
+
+	std::string_view name = ReadToken(source, pos);
+
+	if (name.empty() || (name == "_") || (name[0] == '#'))
+	{
+		return false;
+	}
+
+	// A supertype-qualified node, (supertype/subtype), is a subtype node.
+	const size_t slash = name.rfind('/');
+
+	if (slash != std::string_view::npos)
+	{
+		name.remove_prefix(slash + 1);
+	}
+	return names.Insert(name, roots);
+}
+}
+
+CTSQuery::CTSQuery(const CTSLanguage* lang, const char* oldstr) : CTSQuery(lang->GetTSLanguage(), lang, std::string_view(oldstr))
 {
-    const auto source = std::string(oldstr);
-	m_query = ts_query_new(lang->GetTSLanguage(), source.c_str(), static_cast<uint32_t>(source.length()), &m_error_offset, &m_error_code);
 }
 
+CTSQuery::CTSQuery(const TSLanguage* language, std::string_view source) : CTSQuery(language, nullptr, source)
+{
+}
 
-//CTSQuery::CTSQuery(const CTSLanguage *lang, std::string &source)
-//{
-//    m_query = ts_query_new(lang->GetTSLanguage(), source.c_str(), source.length(), &m_error_offset, &m_error_code);
-//}
+CTSQuery::CTSQuery(const TSLanguage* language, const CTSLanguage* tables, std::string_view source) :
+	m_source_hash(CTSContentHash(source))
+{
+	m_account = CTSMemoryAccount::Create();
+	const CTSMemoryScope scope(m_account);
+	m_query = ts_query_new(language, source.data(), static_cast<uint32_t>(source.length()), &m_error_offset, &m_error_code);
+
+	if (m_query)
+	{
+		FindRootSymbols(language, tables, source);
+	}
+}
+
+void CTSQuery::FindRootSymbols(const TSLanguage* language, const CTSLanguage* tables, std::string_view source)
+{
+	const RootNames names{ language, tables };
+	const uint32_t count = PatternCount();
+
+	for (uint32_t idx = 0; idx < count; idx++)
+	{
+		if (!IsPatternRooted(idx) || !CollectRoots(source, StartByteForPattern(idx), names, m_root_symbols))
+		{
+			m_unrestricted_roots = true;
+			return;
+		}
+	}
+}
 
 CTSQuery::~CTSQuery()
 {
 	if (m_query)
 		ts_query_delete(m_query);
+
+	if (m_account)
+		m_account->Release();
 }
 
 uint32_t CTSQuery::PatternCount() const
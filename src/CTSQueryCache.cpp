@@ -0,0 +1,108 @@
+#include "CTSQueryCache.h"
+#include "CTSSymbolTable.h"
+
+#include <algorithm>
+
+CTSQueryCache::CTSQueryCache(size_t capacity) : m_capacity(capacity)
+{
+}
+
+std::shared_ptr<const CTSQuery>CTSQueryCache::Get(const TSLanguage *language, std::string_view source)
+{
+    const uint64_t hash = CTSNameHash(source);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto                  found = m_index.find({ language, hash, source });
+
+        if (found != m_index.end())
+        {
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            m_stats.hits++;
+            return found->second->query;
+        }
+        m_stats.misses++;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto       query = std::make_shared<const CTSQuery>(language, source);
+    const auto took  = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_stats.compilations++;
+    m_stats.compile_time    += took;
+    m_stats.max_compile_time = std::max(m_stats.max_compile_time, took);
+
+    // Another thread may have compiled the same query in the meantime; keep
+    // the first one so that every caller shares a single instance.
+    const auto found = m_index.find({ language, hash, source });
+
+    if (found != m_index.end())
+    {
+        return found->second->query;
+    }
+
+    if (m_capacity == 0)
+    {
+        return query;
+    }
+
+    m_entries.push_front({ language, hash, std::string(source), query });
+
+    const Entry& entry = m_entries.front();
+
+    m_index.emplace(Key{ entry.language, entry.hash, entry.source }, m_entries.begin());
+    EvictLocked();
+
+    return query;
+}
+
+void CTSQueryCache::EvictLocked()
+{
+    while (m_entries.size() > m_capacity)
+    {
+        const Entry& entry = m_entries.back();
+
+        m_index.erase({ entry.language, entry.hash, entry.source });
+        m_entries.pop_back();
+        m_stats.evictions++;
+    }
+}
+
+size_t CTSQueryCache::Size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_entries.size();
+}
+
+size_t CTSQueryCache::Capacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_capacity;
+}
+
+void CTSQueryCache::SetCapacity(size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_capacity = capacity;
+    EvictLocked();
+}
+
+void CTSQueryCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_index.clear();
+    m_entries.clear();
+}
+
+CTSQueryCacheStats CTSQueryCache::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_stats;
+}
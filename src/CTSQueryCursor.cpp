@@ -1,5 +1,7 @@
 #include "CTSQueryCursor.h"
 
+using Clock = std::chrono::steady_clock;
+
 CTSQueryCursor::CTSQueryCursor()
 {
 	m_cursor = ts_query_cursor_new();
@@ -7,13 +9,48 @@ CTSQueryCursor::CTSQueryCursor()
 
 CTSQueryCursor::~CTSQueryCursor()
 {
+	FlushStats();
 	ts_query_cursor_delete(m_cursor);
 }
 
 void CTSQueryCursor::Exec(const CTSQuery& query, CTSNode node) const
 {
 	const TSQuery* q = query.RawQuery();
+
+	if (!m_metrics)
+	{
+		ts_query_cursor_exec(m_cursor, q, node);
+		return;
+	}
+
+	FlushStats();
+
+	const auto start = Clock::now();
 	ts_query_cursor_exec(m_cursor, q, node);
+
+	m_stats = CTSQueryStats();
+	m_stats.query_hash = query.SourceHash();
+	m_stats.pattern_count = query.PatternCount();
+	m_stats.start_byte = node.StartByte();
+	m_stats.end_byte = node.EndByte();
+	m_stats.wall_time = Clock::now() - start;
+	m_stats_open = true;
+}
+
+void CTSQueryCursor::SetMetricsSink(CTSMetricsSink* sink)
+{
+	FlushStats();
+	m_metrics = sink;
+}
+
+void CTSQueryCursor::FlushStats() const
+{
+	if (m_stats_open && m_metrics)
+	{
+		m_stats.exceeded_match_limit = DidExceedMatchLimit();
+		m_metrics->OnQuery(m_stats);
+	}
+	m_stats_open = false;
 }
 
 bool CTSQueryCursor::DidExceedMatchLimit() const
@@ -43,7 +80,27 @@ void CTSQueryCursor::SetPointRange(TSPoint start, TSPoint end) const
 
 bool CTSQueryCursor::NextMatch()
 {
-	return ts_query_cursor_next_match(m_cursor, &m_last_match);
+	if (!m_metrics)
+	{
+		return ts_query_cursor_next_match(m_cursor, &m_last_match);
+	}
+
+	const auto start = Clock::now();
+	const bool retval = ts_query_cursor_next_match(m_cursor, &m_last_match);
+
+	m_stats.wall_time += Clock::now() - start;
+	m_stats.steps++;
+
+	if (retval)
+	{
+		m_stats.matches++;
+		m_stats.captures += m_last_match.capture_count;
+	}
+	else
+	{
+		FlushStats();
+	}
+	return retval;
 }
 
 void CTSQueryCursor::RemoveMatch(uint32_t id) const
@@ -53,5 +110,119 @@ void CTSQueryCursor::RemoveMatch(uint32_t id) const
 
 bool CTSQueryCursor::NextCapture()
 {
-	return ts_query_cursor_next_capture(m_cursor, &m_last_match, &m_last_index);
+	if (!m_metrics)
+	{
+		return ts_query_cursor_next_capture(m_cursor, &m_last_match, &m_last_index);
+	}
+
+	const auto start = Clock::now();
+	const bool retval = ts_query_cursor_next_capture(m_cursor, &m_last_match, &m_last_index);
+
+	m_stats.wall_time += Clock::now() - start;
+	m_stats.steps++;
+
+	if (retval)
+	{
+		m_stats.captures++;
+	}
+	else
+	{
+		FlushStats();
+	}
+	return retval;
+}
+
+bool CTSQueryCursor::NextMatch(const CTSQueryPredicates& predicates, std::string_view source)
+{
+	while (NextMatch())
+	{
+		if (predicates.Satisfies(m_last_match, source))
+		{
+			return true;
+		}
+
+		if (m_metrics)
+		{
+			m_stats.predicate_rejections++;
+		}
+	}
+	return false;
+}
+
+bool CTSQueryCursor::NextCapture(const CTSQueryPredicates& predicates, std::string_view source)
+{
+	while (NextCapture())
+	{
+		if (predicates.Satisfies(m_last_match, source))
+		{
+			return true;
+		}
+
+		if (m_metrics)
+		{
+			m_stats.predicate_rejections++;
+		}
+		RemoveMatch(m_last_match.id);
+	}
+	return false;
+}
+
+size_t CTSQueryCursor::CollectAll(CTSQueryResults& results)
+{
+	TSQueryMatch match;
+
+	results.Clear();
+
+	const auto start = m_metrics ? Clock::now() : Clock::time_point();
+
+	while (ts_query_cursor_next_match(m_cursor, &match))
+	{
+		results.AppendMatch(match);
+	}
+
+	if (m_metrics)
+	{
+		m_stats.wall_time += Clock::now() - start;
+		m_stats.steps += static_cast<uint32_t>(results.MatchCount()) + 1;
+		m_stats.matches += static_cast<uint32_t>(results.MatchCount());
+		m_stats.captures += static_cast<uint32_t>(results.CaptureCount());
+		FlushStats();
+	}
+	return results.MatchCount();
+}
+
+size_t CTSQueryCursor::CollectAll(const CTSQuery& query, CTSNode node, CTSQueryResults& results)
+{
+	Exec(query, node);
+	return CollectAll(results);
+}
+
+size_t CTSQueryCursor::CollectAllCaptures(CTSQueryResults& results)
+{
+	TSQueryMatch match;
+	uint32_t capture_index;
+
+	results.Clear();
+
+	const auto start = m_metrics ? Clock::now() : Clock::time_point();
+
+	while (ts_query_cursor_next_capture(m_cursor, &match, &capture_index))
+	{
+		results.AppendCapture(match, capture_index);
+	}
+
+	if (m_metrics)
+	{
+		m_stats.wall_time += Clock::now() - start;
+		m_stats.steps += static_cast<uint32_t>(results.CaptureCount()) + 1;
+		m_stats.captures += static_cast<uint32_t>(results.CaptureCount());
+		FlushStats();
+	}
+	return results.CaptureCount();
+}
+
+size_t CTSQueryCursor::CollectAllCaptures(const CTSQuery& query, CTSNode node, CTSQueryResults& results)
+{
+	Exec(query, node);
+	return CollectAllCaptures(results);
 }
@@ -0,0 +1,175 @@
+#include "CTSQueryExecutor.h"
+
+#include <algorithm>
+
+namespace
+{
+// True if the byte span [start, end) touches any of ranges[0 .. limit).
+// Empty spans count as touching a range that contains their position.
+bool IntersectsEarlierRange(const std::vector<TSRange>& ranges, size_t limit,
+                            uint32_t start, uint32_t end)
+{
+    const auto last = ranges.begin() + static_cast<std::ptrdiff_t>(limit);
+    const auto it   = std::upper_bound(ranges.begin(), last, start,
+                                       [](uint32_t byte, const TSRange& range)
+                                       {
+                                           return byte < range.end_byte;
+                                       });
+
+    return (it != last) && (it->start_byte < std::max(end, start + 1));
+}
+}
+
+CTSQueryExecutor::CTSQueryExecutor(unsigned thread_count) : m_pool(thread_count)
+{
+    for (unsigned idx = 0; idx < m_pool.ThreadCount(); idx++)
+    {
+        m_cursors.push_back(std::make_unique<CTSQueryCursor>());
+    }
+}
+
+CTSQueryExecutor::~CTSQueryExecutor() = default;
+
+void CTSQueryExecutor::SetMatchLimit(uint32_t limit) const
+{
+    for (const auto& cursor : m_cursors)
+    {
+        cursor->SetMatchLimit(limit);
+    }
+}
+
+void CTSQueryExecutor::CollectMatches(CTSQueryCursor                 & cursor,
+                                      size_t                           source,
+                                      std::vector<CTSQueryExecCapture>& out,
+                                      const std::vector<TSRange>      *ranges)
+{
+    uint32_t match_ordinal = 0;
+
+    while (cursor.NextMatch())
+    {
+        const TSQueryMatch match = cursor.GetMatchResult();
+
+        if (ranges && (source > 0) && (match.capture_count > 0))
+        {
+            uint32_t start = UINT32_MAX;
+            uint32_t end   = 0;
+
+            for (uint16_t idx = 0; idx < match.capture_count; idx++)
+            {
+                start = std::min(start, ts_node_start_byte(match.captures[idx].node));
+                end   = std::max(end, ts_node_end_byte(match.captures[idx].node));
+            }
+
+            // Reported by an earlier range already.
+            if (IntersectsEarlierRange(*ranges, source, start, end))
+            {
+                continue;
+            }
+        }
+
+        for (uint16_t idx = 0; idx < match.capture_count; idx++)
+        {
+            out.push_back({ source, match_ordinal, match.pattern_index,
+                            match.captures[idx].index, match.captures[idx].node });
+        }
+        match_ordinal++;
+    }
+
+    if (cursor.DidExceedMatchLimit())
+    {
+        m_exceeded_match_limit.store(true, std::memory_order_relaxed);
+    }
+}
+
+std::vector<CTSQueryExecCapture>CTSQueryExecutor::Merge(std::vector<std::vector<CTSQueryExecCapture> >& parts)
+{
+    size_t total = 0;
+
+    for (const auto& part : parts)
+    {
+        total += part.size();
+    }
+
+    std::vector<CTSQueryExecCapture> retval;
+    retval.reserve(total);
+
+    for (auto& part : parts)
+    {
+        retval.insert(retval.end(), part.begin(), part.end());
+        part.clear();
+    }
+    return retval;
+}
+
+std::vector<CTSQueryExecCapture>CTSQueryExecutor::ExecTrees(const CTSQuery                              & query,
+                                                            const std::vector<std::shared_ptr<CTSTree> >& trees)
+{
+    std::vector<std::vector<CTSQueryExecCapture> > parts(trees.size());
+
+    m_exceeded_match_limit = false;
+
+    if (!query.IsValid())
+    {
+        return {};
+    }
+
+    m_pool.ParallelFor(trees.size(), [&](size_t index, unsigned worker)
+                       {
+                           if (!trees[index])
+                           {
+                               return;
+                           }
+
+                           CTSQueryCursor& cursor = *m_cursors[worker];
+
+                           cursor.SetByteRange(0, UINT32_MAX);
+                           cursor.Exec(query, trees[index]->RootNode());
+                           CollectMatches(cursor, index, parts[index], nullptr);
+                       });
+
+    return Merge(parts);
+}
+
+std::vector<CTSQueryExecCapture>CTSQueryExecutor::ExecRanges(const CTSQuery                 & query,
+                                                             const std::shared_ptr<CTSTree>& tree,
+                                                             const std::vector<TSRange>    & ranges)
+{
+    std::vector<std::vector<CTSQueryExecCapture> > parts(ranges.size());
+    std::vector<std::shared_ptr<CTSTree> > copies(m_pool.ThreadCount());
+
+    m_exceeded_match_limit = false;
+
+    if (!query.IsValid() || !tree)
+    {
+        return {};
+    }
+
+    m_pool.ParallelFor(ranges.size(), [&](size_t index, unsigned worker)
+                       {
+                           // Only this worker touches its slot, so the copy can be made lazily.
+                           if (!copies[worker])
+                           {
+                               copies[worker] = tree->Copy(tree.get());
+                           }
+
+                           CTSQueryCursor& cursor = *m_cursors[worker];
+
+                           cursor.SetByteRange(ranges[index].start_byte, ranges[index].end_byte);
+                           cursor.Exec(query, copies[worker]->RootNode());
+                           CollectMatches(cursor, index, parts[index], &ranges);
+                       });
+
+    // A copy shares all of its nodes with the original tree, so pointing the
+    // captures back at the original keeps them valid once the copies are gone.
+    const TSTree *original = tree->RootNode().tree;
+
+    for (auto& part : parts)
+    {
+        for (auto& capture : part)
+        {
+            capture.node.tree = original;
+        }
+    }
+
+    return Merge(parts);
+}
@@ -0,0 +1,319 @@
+#include "CTSQueryPredicates.h"
+
+namespace
+{
+// The node captured as capture_id the nth time in the match, if any.
+bool NthCapture(const TSQueryMatch& match, uint32_t capture_id, uint32_t nth, TSNode *node)
+{
+    for (uint16_t idx = 0; idx < match.capture_count; idx++)
+    {
+        if (match.captures[idx].index == capture_id)
+        {
+            if (nth == 0)
+            {
+                *node = match.captures[idx].node;
+                return true;
+            }
+            nth--;
+        }
+    }
+    return false;
+}
+}
+
+CTSQueryPredicates::CTSQueryPredicates(const CTSQuery& query)
+{
+    // Intern every string of the query up front, so that predicates can refer
+    // to them by id and views into them stay valid.
+    const uint32_t string_count = query.StringCount();
+
+    m_strings.reserve(string_count);
+
+    for (uint32_t idx = 0; idx < string_count; idx++)
+    {
+        m_strings.push_back(query.StringValueForId(idx));
+    }
+
+    const uint32_t pattern_count = query.PatternCount();
+
+    m_patterns.resize(pattern_count);
+
+    for (uint32_t idx = 0; idx < pattern_count; idx++)
+    {
+        if (!Compile(idx, query.PredicatesForPattern(idx)) && (m_error_pattern == UINT32_MAX))
+        {
+            m_error_pattern = idx;
+        }
+    }
+}
+
+bool CTSQueryPredicates::Compile(uint32_t pattern_index, const std::vector<TSQueryPredicateStep>& steps)
+{
+    Pattern& pattern = m_patterns[pattern_index];
+    bool     retval  = true;
+
+    for (size_t first = 0; first < steps.size(); )
+    {
+        size_t last = first;
+
+        while ((last < steps.size()) && (steps[last].type != TSQueryPredicateStepTypeDone))
+        {
+            last++;
+        }
+
+        const TSQueryPredicateStep *args  = steps.data() + first + 1;
+        const size_t                nargs = (last > first) ? last - first - 1 : 0;
+
+        if ((last > first) && (steps[first].type == TSQueryPredicateStepTypeString))
+        {
+            std::string_view name = m_strings[steps[first].value_id];
+            Predicate        predicate{};
+            bool             known = true;
+
+            if (name == "set!")
+            {
+                CTSQueryProperty property;
+                size_t           next = 0;
+
+                if ((nargs > 0) && (args[0].type == TSQueryPredicateStepTypeCapture))
+                {
+                    property.has_capture = true;
+                    property.capture_id  = args[0].value_id;
+                    next++;
+                }
+
+                if ((next < nargs) && (args[next].type == TSQueryPredicateStepTypeString))
+                {
+                    property.key = m_strings[args[next].value_id];
+                    next++;
+
+                    if ((next < nargs) && (args[next].type == TSQueryPredicateStepTypeString))
+                    {
+                        property.value = m_strings[args[next].value_id];
+                    }
+                    pattern.properties.push_back(property);
+                }
+                first = last + 1;
+                continue;
+            }
+
+            // "any-of?" is its own predicate, not an "any-" variant of "of?".
+            if ((name == "any-of?") || (name == "not-any-of?"))
+            {
+                predicate.op     = Op::AnyOf;
+                predicate.negate = name.front() == 'n';
+            }
+            else
+            {
+                if (name.substr(0, 4) == "any-")
+                {
+                    predicate.any = true;
+                    name.remove_prefix(4);
+                }
+
+                if (name.substr(0, 4) == "not-")
+                {
+                    predicate.negate = true;
+                    name.remove_prefix(4);
+                }
+
+                if (name == "eq?")
+                {
+                    predicate.op = Op::Eq;
+                }
+                else if (name == "match?")
+                {
+                    predicate.op = Op::Match;
+                }
+                else
+                {
+                    known = false;
+                }
+            }
+
+            if (known && !Add(pattern, predicate, args, nargs))
+            {
+                // A malformed predicate can never be satisfied: nothing is a
+                // member of an empty set.
+                predicate.op     = Op::AnyOf;
+                predicate.negate = false;
+                predicate.any    = true;
+                predicate.rhs    = static_cast<uint32_t>(m_sets.size());
+                m_sets.emplace_back();
+                pattern.predicates.push_back(predicate);
+                retval = false;
+            }
+        }
+        first = last + 1;
+    }
+    return retval;
+}
+
+bool CTSQueryPredicates::Add(Pattern& pattern, Predicate predicate, const TSQueryPredicateStep *args, size_t nargs)
+{
+    if ((nargs < 2) || (args[0].type != TSQueryPredicateStepTypeCapture) ||
+        ((predicate.op != Op::AnyOf) && (nargs != 2)))
+    {
+        return false;
+    }
+
+    predicate.capture_id = args[0].value_id;
+
+    if (predicate.op == Op::Eq)
+    {
+        predicate.rhs_is_capture = args[1].type == TSQueryPredicateStepTypeCapture;
+        predicate.rhs            = args[1].value_id;
+    }
+    else if (args[1].type != TSQueryPredicateStepTypeString)
+    {
+        return false;
+    }
+    else if (predicate.op == Op::Match)
+    {
+        // std::regex reports invalid patterns by throwing; keep that from
+        // escaping the constructor.
+        try
+        {
+            m_regexes.emplace_back(m_strings[args[1].value_id], std::regex::ECMAScript | std::regex::optimize);
+        }
+        catch (const std::regex_error&)
+        {
+            return false;
+        }
+        predicate.rhs = static_cast<uint32_t>(m_regexes.size() - 1);
+    }
+    else
+    {
+        std::unordered_set<std::string_view> values;
+
+        for (size_t idx = 1; idx < nargs; idx++)
+        {
+            if (args[idx].type != TSQueryPredicateStepTypeString)
+            {
+                return false;
+            }
+            values.insert(m_strings[args[idx].value_id]);
+        }
+
+        m_sets.push_back(std::move(values));
+        predicate.rhs = static_cast<uint32_t>(m_sets.size() - 1);
+    }
+
+    pattern.predicates.push_back(predicate);
+    return true;
+}
+
+bool CTSQueryPredicates::HasPredicates(uint32_t pattern_index) const
+{
+    return (pattern_index < m_patterns.size()) && !m_patterns[pattern_index].predicates.empty();
+}
+
+const std::vector<CTSQueryProperty>& CTSQueryPredicates::Properties(uint32_t pattern_index) const
+{
+    static const std::vector<CTSQueryProperty> none;
+
+    return (pattern_index < m_patterns.size()) ? m_patterns[pattern_index].properties : none;
+}
+
+std::string_view CTSQueryPredicates::Property(uint32_t pattern_index, std::string_view key) const
+{
+    for (const CTSQueryProperty& property : Properties(pattern_index))
+    {
+        if (property.key == key)
+        {
+            return property.value;
+        }
+    }
+    return {};
+}
+
+std::string_view CTSQueryPredicates::NodeText(TSNode node, std::string_view source)
+{
+    const uint32_t start = ts_node_start_byte(node);
+    const uint32_t end   = ts_node_end_byte(node);
+
+    if ((start > end) || (end > source.size()))
+    {
+        return {};
+    }
+    return source.substr(start, end - start);
+}
+
+bool CTSQueryPredicates::Test(const Predicate& predicate, std::string_view text) const
+{
+    switch (predicate.op)
+    {
+    case Op::Eq:
+        return text == m_strings[predicate.rhs];
+
+    case Op::Match:
+        return std::regex_search(text.begin(), text.end(), m_regexes[predicate.rhs]);
+
+    case Op::AnyOf:
+        return m_sets[predicate.rhs].count(text) != 0;
+    }
+    return false;
+}
+
+bool CTSQueryPredicates::Satisfies(const TSQueryMatch& match, std::string_view source) const
+{
+    if (match.pattern_index >= m_patterns.size())
+    {
+        return true;
+    }
+
+    for (const Predicate& predicate : m_patterns[match.pattern_index].predicates)
+    {
+        const bool pairs  = (predicate.op == Op::Eq) && predicate.rhs_is_capture;
+        bool       passed = !predicate.any;
+        TSNode     node;
+
+        for (uint32_t nth = 0;; nth++)
+        {
+            const bool has_node = NthCapture(match, predicate.capture_id, nth, &node);
+            TSNode     other;
+
+            if (pairs)
+            {
+                // Quantified captures are compared node by node, and must
+                // run out together.
+                const bool has_other = NthCapture(match, predicate.rhs, nth, &other);
+
+                if (has_node != has_other)
+                {
+                    passed = false;
+                    break;
+                }
+            }
+
+            if (!has_node)
+            {
+                break;
+            }
+
+            const std::string_view text = NodeText(node, source);
+
+            const bool result = pairs ? (NodeText(other, source) == text) : Test(predicate, text);
+
+            if (result != predicate.negate)
+            {
+                if (predicate.any)
+                {
+                    passed = true;
+                    break;
+                }
+            }
+            else if (!predicate.any)
+            {
+                passed = false;
+                break;
+            }
+        }
+
+        if (!passed)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "CTSQueryRange.h"
+#include "CTSQueryCursor.h"
+
+CTSQueryMatchIterator::CTSQueryMatchIterator(CTSQueryCursor           *cursor,
+                                             const CTSQueryPredicates *predicates,
+                                             std::string_view          source) :
+    m_cursor(cursor),
+    m_predicates(predicates),
+    m_source(source)
+{
+    ++(*this);
+}
+
+CTSQueryMatchIterator& CTSQueryMatchIterator::operator++()
+{
+    if (m_cursor && (m_predicates ? m_cursor->NextMatch(*m_predicates, m_source) : m_cursor->NextMatch()))
+    {
+        m_match = m_cursor->GetMatchResult();
+    }
+    else
+    {
+        m_cursor = nullptr;
+    }
+    return *this;
+}
+
+CTSQueryCaptureIterator::CTSQueryCaptureIterator(CTSQueryCursor           *cursor,
+                                                 const CTSQueryPredicates *predicates,
+                                                 std::string_view          source) :
+    m_cursor(cursor),
+    m_predicates(predicates),
+    m_source(source)
+{
+    ++(*this);
+}
+
+CTSQueryCaptureIterator& CTSQueryCaptureIterator::operator++()
+{
+    if (m_cursor && (m_predicates ? m_cursor->NextCapture(*m_predicates, m_source) : m_cursor->NextCapture()))
+    {
+        m_capture.match         = m_cursor->GetMatchResult();
+        m_capture.capture_index = m_cursor->GetCaptureIndex();
+    }
+    else
+    {
+        m_cursor = nullptr;
+    }
+    return *this;
+}
@@ -0,0 +1,48 @@
+#include "CTSQueryResults.h"
+
+void CTSQueryResults::Clear()
+{
+    m_match_ids.clear();
+    m_pattern_indices.clear();
+    m_capture_ids.clear();
+    m_nodes.clear();
+    m_start_bytes.clear();
+    m_end_bytes.clear();
+    m_match_patterns.clear();
+    m_match_starts.assign(1, 0);
+}
+
+void CTSQueryResults::Reserve(size_t captures, size_t matches)
+{
+    m_match_ids.reserve(captures);
+    m_pattern_indices.reserve(captures);
+    m_capture_ids.reserve(captures);
+    m_nodes.reserve(captures);
+    m_start_bytes.reserve(captures);
+    m_end_bytes.reserve(captures);
+    m_match_patterns.reserve(matches);
+    m_match_starts.reserve(matches + 1);
+}
+
+void CTSQueryResults::AppendCapture(const TSQueryMatch& match, uint32_t capture_index)
+{
+    const TSQueryCapture& capture = match.captures[capture_index];
+
+    m_match_ids.push_back(match.id);
+    m_pattern_indices.push_back(match.pattern_index);
+    m_capture_ids.push_back(capture.index);
+    m_nodes.push_back(capture.node);
+    m_start_bytes.push_back(ts_node_start_byte(capture.node));
+    m_end_bytes.push_back(ts_node_end_byte(capture.node));
+}
+
+void CTSQueryResults::AppendMatch(const TSQueryMatch& match)
+{
+    for (uint16_t idx = 0; idx < match.capture_count; idx++)
+    {
+        AppendCapture(match, idx);
+    }
+
+    m_match_patterns.push_back(match.pattern_index);
+    m_match_starts.push_back(static_cast<uint32_t>(m_nodes.size()));
+}
@@ -0,0 +1,111 @@
+#include "CTSQuerySet.h"
+
+#include <string>
+#include <unordered_map>
+
+CTSQuerySet::CTSQuerySet(const TSLanguage *language, const std::vector<std::string_view>& sources)
+{
+    std::string           combined;
+    std::vector<uint32_t> offsets;
+
+    for (uint32_t idx = 0; idx < sources.size(); idx++)
+    {
+        Source source;
+
+        source.query = std::make_unique<CTSQuery>(language, sources[idx]);
+
+        if (!source.query->IsValid() && (m_error_source == UINT32_MAX))
+        {
+            m_error_source = idx;
+        }
+        m_sources.push_back(std::move(source));
+
+        // A line break keeps a trailing comment from swallowing the next source.
+        offsets.push_back(static_cast<uint32_t>(combined.size()));
+        combined.append(sources[idx]);
+        combined.push_back('\n');
+    }
+
+    m_query = std::make_unique<CTSQuery>(language, combined);
+
+    if (!IsValid() || !m_query->IsValid())
+    {
+        if (m_error_source == UINT32_MAX)
+        {
+            m_error_source = 0;
+        }
+        m_first_patterns.assign(m_sources.size() + 1, 0);
+        return;
+    }
+
+    // Patterns are numbered in the order they appear in the text, so each
+    // source owns a contiguous run of them.
+    const uint32_t pattern_count = m_query->PatternCount();
+    uint32_t       source        = 0;
+
+    m_pattern_sources.resize(pattern_count);
+    m_first_patterns.push_back(0);
+
+    for (uint32_t idx = 0; idx < pattern_count; idx++)
+    {
+        const uint32_t start = m_query->StartByteForPattern(idx);
+
+        while ((source + 1 < offsets.size()) && (start >= offsets[source + 1]))
+        {
+            m_first_patterns.push_back(idx);
+            source++;
+        }
+        m_pattern_sources[idx] = source;
+    }
+
+    while (m_first_patterns.size() < m_sources.size() + 1)
+    {
+        m_first_patterns.push_back(pattern_count);
+    }
+
+    // Capture ids are assigned per query by name, so match them up by name.
+    const uint32_t capture_count = m_query->CaptureCount();
+
+    for (Source& entry : m_sources)
+    {
+        std::unordered_map<std::string, uint32_t> local_ids;
+
+        for (uint32_t idx = 0; idx < entry.query->CaptureCount(); idx++)
+        {
+            local_ids.emplace(entry.query->CaptureNameForId(idx), idx);
+        }
+
+        entry.local_capture_ids.assign(capture_count, NoCapture);
+
+        for (uint32_t idx = 0; idx < capture_count; idx++)
+        {
+            const auto found = local_ids.find(m_query->CaptureNameForId(idx));
+
+            if (found != local_ids.end())
+            {
+                entry.local_capture_ids[idx] = found->second;
+            }
+        }
+    }
+}
+
+CTSQuerySetOrigin CTSQuerySet::PatternOrigin(uint32_t pattern_index) const
+{
+    CTSQuerySetOrigin retval;
+
+    if (pattern_index < m_pattern_sources.size())
+    {
+        retval.source        = m_pattern_sources[pattern_index];
+        retval.pattern_index = pattern_index - m_first_patterns[retval.source];
+    }
+    return retval;
+}
+
+uint32_t CTSQuerySet::LocalCaptureId(uint32_t source, uint32_t capture_id) const
+{
+    if ((source >= m_sources.size()) || (capture_id >= m_sources[source].local_capture_ids.size()))
+    {
+        return NoCapture;
+    }
+    return m_sources[source].local_capture_ids[capture_id];
+}
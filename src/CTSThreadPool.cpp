@@ -0,0 +1,154 @@
+#include "CTSThreadPool.h"
+
+CTSThreadPool::CTSThreadPool(unsigned thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::thread::hardware_concurrency();
+    }
+
+    if (thread_count == 0)
+    {
+        thread_count = 1;
+    }
+
+    for (unsigned idx = 0; idx < thread_count; idx++)
+    {
+        m_ranges.push_back(std::make_unique<WorkRange>());
+    }
+
+    for (unsigned idx = 0; idx < thread_count; idx++)
+    {
+        m_threads.emplace_back(&CTSThreadPool::WorkerMain, this, idx);
+    }
+}
+
+CTSThreadPool::~CTSThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void CTSThreadPool::ParallelFor(size_t count, const Task& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit_lock(m_submit_mutex);
+
+    // Hand every worker an equal contiguous slice up front; stealing evens
+    // out whatever imbalance remains.
+    const size_t workers = m_ranges.size();
+
+    for (size_t idx = 0; idx < workers; idx++)
+    {
+        std::lock_guard<std::mutex> lock(m_ranges[idx]->mutex);
+        m_ranges[idx]->begin = count * idx / workers;
+        m_ranges[idx]->end   = count * (idx + 1) / workers;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_busy = static_cast<unsigned>(workers);
+    m_generation++;
+    m_wake.notify_all();
+
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+bool CTSThreadPool::TakeIndex(unsigned worker, size_t *index)
+{
+    WorkRange& own = *m_ranges[worker];
+
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+
+        if (own.begin < own.end)
+        {
+            *index = own.begin++;
+            return true;
+        }
+    }
+
+    // Our range is empty: steal the back half of the first victim that still
+    // has work, run its first item now and keep the rest as our own range.
+    const size_t workers = m_ranges.size();
+
+    for (size_t offset = 1; offset < workers; offset++)
+    {
+        WorkRange& victim = *m_ranges[(worker + offset) % workers];
+        size_t     begin  = 0;
+        size_t     end    = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+
+            if (victim.begin >= victim.end)
+            {
+                continue;
+            }
+
+            const size_t middle = victim.begin + (victim.end - victim.begin) / 2;
+
+            begin      = middle;
+            end        = victim.end;
+            victim.end = middle;
+        }
+
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin + 1;
+        own.end   = end;
+        *index    = begin;
+        return true;
+    }
+
+    return false;
+}
+
+void CTSThreadPool::WorkerMain(unsigned worker)
+{
+    uint64_t seen_generation = 0;
+
+    for (;;)
+    {
+        const Task *task = nullptr;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || (m_generation != seen_generation); });
+
+            if (m_stopping)
+            {
+                return;
+            }
+
+            seen_generation = m_generation;
+            task            = m_task;
+        }
+
+        size_t index = 0;
+
+        while (TakeIndex(worker, &index))
+        {
+            (*task)(index, worker);
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (--m_busy == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
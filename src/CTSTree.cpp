@@ -1,4 +1,8 @@
 #include "CTSTree.h"
+#include "CTSTreeWalker.h"
+#include "alloc.h"
+
+#include <unordered_set>
 
 CTSTree::CTSTree(const TSTree* self)
 {
@@ -13,12 +17,28 @@ CTSTree::~CTSTree()
 		ts_tree_delete(const_cast<TSTree*>(m_tree));
 		m_tree = nullptr;
 	}
+
+	if (m_account)
+	{
+		m_account->Release();
+		m_account = nullptr;
+	}
 }
 
 std::shared_ptr<CTSTree> CTSTree::Copy(const CTSTree* source_tree) const
 {
-	TSTree* new_tstree = ts_tree_copy(source_tree->m_tree);
-	return std::make_shared<CTSTree>(new_tstree);
+	CTSMemoryAccount* account = CTSMemoryAccount::Create();
+	TSTree* new_tstree;
+	{
+		CTSMemoryScope scope(account);
+		new_tstree = ts_tree_copy(source_tree->m_tree);
+	}
+
+	auto retval = std::make_shared<CTSTree>(new_tstree);
+	retval->m_account = account;
+	retval->m_arenas = source_tree->m_arenas;
+	retval->m_parse_stats = source_tree->m_parse_stats;
+	return retval;
 }
 
 CTSNode CTSTree::RootNode() const
@@ -36,6 +56,14 @@ void CTSTree::Edit(const TSInputEdit* edit) const
 	ts_tree_edit(m_tree, edit);
 }
 
+void CTSTree::Edit(const std::vector<TSInputEdit>& edits) const
+{
+	for (const auto& edit : edits)
+	{
+		ts_tree_edit(m_tree, &edit);
+	}
+}
+
 std::vector<TSRange> CTSTree::GetChangedRanges(const std::shared_ptr<CTSTree>& new_tree) const
 {
 	std::vector<TSRange> retval;
@@ -46,7 +74,65 @@ std::vector<TSRange> CTSTree::GetChangedRanges(const std::shared_ptr<CTSTree>& n
 		TSRange temp = items[i];
 		retval.push_back(temp);
 	}
-	free(items);
+	// The array comes from tree-sitter's allocator, which may be CTSMemory's.
+	ts_current_free(items);
+	return retval;
+}
+
+CTSTreeMemoryUsage CTSTree::MemoryUsage(const CTSTree* other) const
+{
+	CTSTreeMemoryUsage retval;
+
+	// Only nodes with children are backed by their own heap allocation; leaves
+	// may be stored inline, and their ids are not unique, so they count as
+	// shared only below a shared parent.
+	std::unordered_set<const void*> other_ids;
+
+	if (other && other->m_tree)
+	{
+		for (const CTSNode node : CTSTreeWalker::PreOrder(other->RootNode()))
+		{
+			if (node.ChildCount() > 0)
+			{
+				other_ids.insert(node.id);
+			}
+		}
+	}
+
+	uint32_t shared_depth = UINT32_MAX;
+
+	CTSTreeWalker::Walk(RootNode(),
+		[&](const CTSTreeCursor& cursor, uint32_t depth)
+		{
+			retval.node_count++;
+
+			if (shared_depth == UINT32_MAX && !other_ids.empty())
+			{
+				const CTSNode node = cursor.CurrentNode();
+
+				if (node.ChildCount() > 0 && other_ids.count(node.id))
+				{
+					shared_depth = depth;
+				}
+			}
+
+			if (shared_depth != UINT32_MAX)
+			{
+				retval.shared_node_count++;
+			}
+			return CTSVisitAction::Continue;
+		},
+		[&](const CTSTreeCursor&, uint32_t depth)
+		{
+			if (depth == shared_depth)
+			{
+				shared_depth = UINT32_MAX;
+			}
+		});
+
+	retval.estimated_bytes = static_cast<size_t>(retval.node_count) * EstimatedBytesPerNode;
+	retval.estimated_unique_bytes = static_cast<size_t>(retval.node_count - retval.shared_node_count) * EstimatedBytesPerNode;
+	retval.tracked_bytes = m_account ? m_account->Bytes() : 0;
 	return retval;
 }
 
@@ -86,6 +172,14 @@ std::string CTSTreeCursor::CurrentFieldName(bool* was_found) const
 	return s ? std::string(s) : std::string("");
 }
 
+std::string_view CTSTreeCursor::CurrentFieldNameView(bool* was_found) const
+{
+	const auto s = ts_tree_cursor_current_field_name(this);
+
+	if (was_found) { *was_found = (s != nullptr); }
+	return s ? std::string_view(s) : std::string_view();
+}
+
 TSFieldId CTSTreeCursor::CurrentFieldId() const { return ts_tree_cursor_current_field_id(this); }
 
 bool CTSTreeCursor::GotoParent() { return ts_tree_cursor_goto_parent(this); }
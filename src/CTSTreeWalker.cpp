@@ -0,0 +1,94 @@
+#include "CTSTreeWalker.h"
+
+CTSTreeWalkIterator::CTSTreeWalkIterator(CTSNode root, Order order, bool named_only) :
+    m_cursor(new CTSTreeCursor(root)),
+    m_order(order),
+    m_named_only(named_only)
+{
+    if (root.IsNull())
+    {
+        m_cursor.reset();
+        return;
+    }
+
+    if (m_order == Order::PostOrder)
+    {
+        DescendToFirstLeaf();
+    }
+
+    if (!Accept())
+    {
+        ++(*this);
+    }
+}
+
+CTSTreeWalkIterator& CTSTreeWalkIterator::operator++()
+{
+    do
+    {
+        if (!Step())
+        {
+            m_cursor.reset();
+            break;
+        }
+    } while (!Accept());
+
+    return *this;
+}
+
+bool CTSTreeWalkIterator::Step()
+{
+    if (m_order == Order::PostOrder)
+    {
+        if (m_depth == 0)
+        {
+            return false;
+        }
+
+        if (m_cursor->GotoNextSibling())
+        {
+            DescendToFirstLeaf();
+        }
+        else
+        {
+            m_cursor->GotoParent();
+            m_depth--;
+        }
+        return true;
+    }
+
+    const bool skip = m_skip_children;
+
+    m_skip_children = false;
+
+    if (!skip && m_cursor->GotoFirstChild())
+    {
+        m_depth++;
+        return true;
+    }
+
+    while (m_depth > 0)
+    {
+        if (m_cursor->GotoNextSibling())
+        {
+            return true;
+        }
+
+        m_cursor->GotoParent();
+        m_depth--;
+    }
+    return false;
+}
+
+void CTSTreeWalkIterator::DescendToFirstLeaf()
+{
+    while (m_cursor->GotoFirstChild())
+    {
+        m_depth++;
+    }
+}
+
+bool CTSTreeWalkIterator::Accept() const
+{
+    return !m_cursor || !m_named_only || m_cursor->CurrentNode().IsNamed();
+}
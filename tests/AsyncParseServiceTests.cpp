@@ -0,0 +1,177 @@
+#include "TSWrapperTest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+CTSAsyncParseRequest Request(const char *document_id, uint64_t version, std::string source,
+                             std::vector<TSInputEdit> edits = {})
+{
+    CTSAsyncParseRequest retval;
+
+    retval.document_id = document_id;
+    retval.version     = version;
+    retval.source      = std::make_shared<const std::string>(std::move(source));
+    retval.edits       = std::move(edits);
+    return retval;
+}
+
+// A full parse reports the whole document as changed.
+bool CoversWholeDocument(const CTSAsyncParseResult& result, size_t length)
+{
+    return (result.changed_ranges.size() == 1) && (result.changed_ranges[0].start_byte == 0) &&
+           (result.changed_ranges[0].end_byte == length);
+}
+
+// Keeps the worker that runs its callback busy until Open is called.
+class Gate
+{
+public:
+    CTSAsyncParseService::Callback Blocker()
+    {
+        std::shared_future<void> opened = m_open.get_future().share();
+
+        return [this, opened](const CTSAsyncParseResult&)
+               {
+                   m_entered.set_value();
+                   opened.wait();
+               };
+    }
+
+    void WaitEntered() { m_entered_future.wait(); }
+    void Open() { m_open.set_value(); }
+
+private:
+    std::promise<void> m_open;
+    std::promise<void> m_entered;
+    std::future<void>  m_entered_future = m_entered.get_future();
+};
+}
+
+// While the only worker is busy, a second version replaces the first; the
+// survivor still reparses from the last tree, with both edits applied.
+TSWRAPPER_TEST(AsyncSupersededVersion)
+{
+    CTSAsyncParseService service(tree_sitter_json());
+
+    const auto first = service.Submit(Request("doc", 1, "[1, 2]")).get();
+
+    Check(first.status == CTSAsyncParseStatus::Completed, "first version completes");
+
+    Gate gate;
+
+    service.Submit(Request("busy", 1, "[]"), gate.Blocker());
+
+    auto superseded = service.Submit(Request("doc", 2, "[1, 23]", { SingleLineEdit(5, 5, 6) }));
+    auto survivor   = service.Submit(Request("doc", 3, "[1, 234]", { SingleLineEdit(6, 6, 7) }));
+
+    Check(superseded.wait_for(std::chrono::seconds(0)) == std::future_status::ready,
+          "superseded version resolves without a parse");
+    Check(superseded.get().status == CTSAsyncParseStatus::Superseded, "superseded status");
+
+    gate.Open();
+
+    const auto result = survivor.get();
+
+    Check(result.status == CTSAsyncParseStatus::Completed, "survivor completes");
+    Check(result.version == 3, "survivor version");
+    Check(!CoversWholeDocument(result, 8), "survivor parses incrementally");
+    Check(result.tree && (result.tree->RootNode().EndByte() == 8), "survivor tree spans its text");
+    service.WaitIdle();
+}
+
+// Closing a document mid-parse cancels the parse and forgets the tree, so the
+// next version is parsed from scratch even though it carries edits.
+TSWRAPPER_TEST(AsyncCloseInFlight)
+{
+    CTSAsyncParseService service(tree_sitter_json());
+
+    std::string source = "[0";
+
+    for (int idx = 0; idx < 1000000; idx++)
+    {
+        source += ",0";
+    }
+    source += "]";
+
+    auto in_flight = service.Submit(Request("doc", 1, source));
+
+    // The worker takes the request off the queue and marks the document in
+    // flight under the same lock.
+    while (service.QueueSize() != 0)
+    {
+        std::this_thread::yield();
+    }
+    service.Close("doc");
+
+    const auto cancelled = in_flight.get();
+
+    Check(cancelled.status == CTSAsyncParseStatus::Cancelled, "closed parse is cancelled");
+    Check(cancelled.tree == nullptr, "cancelled parse has no tree");
+    Check(service.Tree("doc") == nullptr, "closed document has no tree");
+
+    const auto reopened = service.Submit(Request("doc", 2, "[1, 23]", { SingleLineEdit(5, 5, 6) })).get();
+
+    Check(reopened.status == CTSAsyncParseStatus::Completed, "reopened document completes");
+    Check(CoversWholeDocument(reopened, 7), "reopened document parses from scratch");
+}
+
+TSWRAPPER_TEST(AsyncTrySubmitQueueFull)
+{
+    CTSAsyncParseOptions options;
+
+    options.queue_capacity = 1;
+
+    CTSAsyncParseService service(tree_sitter_json(), options);
+
+    Gate gate;
+
+    service.Submit(Request("busy", 1, "[]"), gate.Blocker());
+    gate.WaitEntered();
+
+    std::future<CTSAsyncParseResult> queued;
+    std::future<CTSAsyncParseResult> replaced;
+
+    Check(service.TrySubmit(Request("a", 1, "[1]"), &queued), "first request fits");
+    Check(!service.TrySubmit(Request("b", 1, "[2]"), nullptr), "full queue turns a request away");
+    Check(service.QueueSize() == 1, "refused request is not queued");
+    Check(service.TrySubmit(Request("a", 2, "[3]"), &replaced), "replacing a waiting version fits");
+
+    gate.Open();
+
+    Check(queued.get().status == CTSAsyncParseStatus::Superseded, "replaced version is superseded");
+    Check(replaced.get().status == CTSAsyncParseStatus::Completed, "replacement completes");
+    service.WaitIdle();
+}
+
+TSWRAPPER_TEST(AsyncWaitIdleAfterCallbacks)
+{
+    CTSAsyncParseOptions options;
+
+    options.thread_count = 2;
+
+    CTSAsyncParseService service(tree_sitter_json(), options);
+    std::atomic<int>     finished{ 0 };
+    const int            count = 8;
+
+    for (int idx = 0; idx < count; idx++)
+    {
+        const std::string id = "doc" + std::to_string(idx);
+
+        service.Submit(Request(id.c_str(), 1, "[1, 2]"), [&finished](const CTSAsyncParseResult&)
+                       {
+                           std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                           finished++;
+                       });
+    }
+    service.WaitIdle();
+
+    Check(finished == count, "every callback returned before WaitIdle");
+}
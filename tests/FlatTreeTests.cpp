@@ -0,0 +1,98 @@
+#include "TSWrapperTest.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+const char *Source = "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"}";
+
+template<typename T>
+bool SameColumn(const T *left, const T *right, uint32_t count)
+{
+    return std::memcmp(left, right, count * sizeof(T)) == 0;
+}
+
+bool SameColumns(const CTSFlatTree& left, const CTSFlatTree& right)
+{
+    const uint32_t count = left.NodeCount();
+
+    return (count == right.NodeCount()) &&
+           SameColumn(left.Symbols(), right.Symbols(), count) &&
+           SameColumn(left.StartBytes(), right.StartBytes(), count) &&
+           SameColumn(left.EndBytes(), right.EndBytes(), count) &&
+           SameColumn(left.StartPoints(), right.StartPoints(), count) &&
+           SameColumn(left.EndPoints(), right.EndPoints(), count) &&
+           SameColumn(left.Parents(), right.Parents(), count) &&
+           SameColumn(left.FirstChildren(), right.FirstChildren(), count) &&
+           SameColumn(left.NextSiblings(), right.NextSiblings(), count) &&
+           SameColumn(left.ChildIndices(), right.ChildIndices(), count) &&
+           SameColumn(left.FieldIds(), right.FieldIds(), count) &&
+           SameColumn(left.Flags(), right.Flags(), count);
+}
+
+// Flatten Source and save it under a fresh name in the temporary directory.
+std::string SaveFlatTree(const CTSParser& parser, const char *name, std::shared_ptr<CTSFlatTree> *flat)
+{
+    const std::string retval = (std::filesystem::temp_directory_path() / name).string();
+
+    *flat = std::make_shared<CTSFlatTree>(parser.ParseString(Source));
+    Check((*flat)->Save(retval, CTSContentHash(Source)), "save");
+    return retval;
+}
+}
+
+TSWRAPPER_TEST(FlatTreeSaveLoad)
+{
+    const CTSParser   parser(tree_sitter_json());
+    const CTSLanguage language(tree_sitter_json());
+
+    std::shared_ptr<CTSFlatTree> flat;
+    const std::string path = SaveFlatTree(parser, "TSWrapperTests-flat.bin", &flat);
+
+    const auto loaded = CTSFlatTree::Load(path, language, CTSContentHash(Source));
+
+    Check(loaded != nullptr, "load");
+
+    if (loaded)
+    {
+        Check(SameColumns(*flat, *loaded), "loaded columns equal saved columns");
+        Check(loaded->SourceHash() == CTSContentHash(Source), "source hash recorded");
+        Check(loaded->Tree() == nullptr, "loaded tree has no CTSTree");
+    }
+    std::filesystem::remove(path);
+}
+
+// CTSParseCache::ParseFlat falls back to parsing whenever Load returns
+// nullptr, so every mismatch must be caught there.
+TSWRAPPER_TEST(FlatTreeLoadRejects)
+{
+    const CTSParser   parser(tree_sitter_json());
+    const CTSLanguage language(tree_sitter_json());
+
+    std::shared_ptr<CTSFlatTree> flat;
+    const std::string path = SaveFlatTree(parser, "TSWrapperTests-reject.bin", &flat);
+
+    Check(CTSFlatTree::Load(path, language, CTSContentHash(Source) + 1) == nullptr, "wrong source hash");
+
+    {
+        // The language fingerprint follows the magic, format version and byte
+        // order mark in the header.
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t     fingerprint = language.Fingerprint() + 1;
+
+        file.seekp(16);
+        file.write(reinterpret_cast<const char *>(&fingerprint), sizeof(fingerprint));
+    }
+    Check(CTSFlatTree::Load(path, language, CTSContentHash(Source)) == nullptr, "wrong fingerprint");
+
+    const std::string truncated = SaveFlatTree(parser, "TSWrapperTests-truncated.bin", &flat);
+
+    std::filesystem::resize_file(truncated, std::filesystem::file_size(truncated) - 1);
+    Check(CTSFlatTree::Load(truncated, language, CTSContentHash(Source)) == nullptr, "truncated file");
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(truncated);
+}
@@ -0,0 +1,51 @@
+#include "TSWrapperTest.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+// Buffers that tree-sitter hands out (changed ranges, node strings) come from
+// the installed allocator and must go back through it, from pools and arenas
+// alike.
+void CheckBuffersFreedThroughInstalledAllocator(const CTSParser& parser)
+{
+    auto tree = parser.ParseString("[1, 2]");
+
+    Check(tree != nullptr, "initial parse");
+
+    if (!tree)
+    {
+        return;
+    }
+
+    // "[1, 2]" becomes "[1, 23]".
+    std::vector<TSRange> changed;
+    auto new_tree = parser.ReparseString(tree, { SingleLineEdit(5, 5, 6) }, "[1, 23]", &changed);
+
+    Check(new_tree != nullptr, "reparse");
+
+    if (!new_tree)
+    {
+        return;
+    }
+
+    Check(!changed.empty(), "changed ranges reported");
+    Check(tree->GetChangedRanges(new_tree) == changed, "GetChangedRanges matches Reparse");
+    Check(new_tree->RootNode().String().find("number") != std::string::npos, "node string");
+}
+}
+
+TSWRAPPER_TEST(HeapAndPoolBuffers)
+{
+    const CTSParser parser(tree_sitter_json());
+
+    CheckBuffersFreedThroughInstalledAllocator(parser);
+}
+
+TSWRAPPER_TEST(ArenaBuffers)
+{
+    const CTSParseSession session(tree_sitter_json());
+
+    CheckBuffersFreedThroughInstalledAllocator(session.Parser());
+}
@@ -0,0 +1,65 @@
+#include "TSWrapperTest.h"
+
+#include <vector>
+
+TSWRAPPER_TEST(QueryRootSymbols)
+{
+    const char *source = "((pair key: (string) @key) (#eq? @key \"\\\"id\\\"\"))\n"
+                         "[(array) \"null\"] @value\n";
+
+    // Names resolve straight from the language, or through the tables of a
+    // CTSLanguage when the query is built from one; both must agree.
+    const CTSLanguage language(tree_sitter_json());
+    const CTSQuery    query(tree_sitter_json(), source);
+    const CTSQuery    from_tables(&language, source);
+
+    for (const CTSQuery *compiled : { &query, &from_tables })
+    {
+        Check(compiled->IsValid(), "query compiles");
+        Check(!compiled->HasUnrestrictedRoots(), "roots are restricted");
+
+        for (const char *name : { "pair", "array", "null" })
+        {
+            for (const TSSymbol symbol : language.SymbolsForName(name))
+            {
+                Check(compiled->RootSymbols().Contains(symbol), name);
+            }
+        }
+
+        for (const TSSymbol symbol : language.SymbolsForName("string"))
+        {
+            Check(!compiled->RootSymbols().Contains(symbol), "string is not a root");
+        }
+    }
+
+    const CTSQuery wildcard(tree_sitter_json(), "(_ (number) @n)");
+
+    Check(wildcard.HasUnrestrictedRoots(), "wildcard roots are unrestricted");
+}
+
+// On a single line, columns equal byte offsets, so every updated range must
+// have matching points.
+TSWRAPPER_TEST(IncrementalRangesAgree)
+{
+    const CTSParser parser(tree_sitter_json());
+    const CTSQuery  query(tree_sitter_json(), "(array (number) @n)");
+
+    CTSIncrementalQuery incremental(query);
+
+    auto tree = parser.ParseString("[1, 2]");
+
+    incremental.Run(tree);
+    Check(incremental.Matches().size() == 2, "initial matches");
+
+    std::vector<TSRange> changed;
+    auto new_tree = parser.ReparseString(tree, { SingleLineEdit(5, 5, 6) }, "[1, 23]", &changed);
+
+    incremental.Update(new_tree, { SingleLineEdit(5, 5, 6) }, changed);
+    Check(incremental.Matches().size() == 2, "updated matches");
+
+    for (const TSRange& range : incremental.UpdatedRanges())
+    {
+        Check((range.start_point.row == 0) && (range.start_point.column == range.start_byte), "start point");
+        Check((range.end_point.row == 0) && (range.end_point.column == range.end_byte), "end point");
+    }
+}
@@ -0,0 +1,16 @@
+#include "TSWrapperTest.h"
+
+TSWRAPPER_TEST(ErrorSymbolSlot)
+{
+    CTSSymbolSet      set;
+    CTSSymbolMap<int> map(-1);
+
+    set.Insert(CTSErrorSymbol);
+    map.Set(CTSErrorSymbol, 7);
+
+    Check(set.Contains(CTSErrorSymbol), "set contains ERROR");
+    Check(!set.Contains(1), "set does not contain other symbols");
+    Check(!set.Empty(), "set is not empty");
+    Check(map[CTSErrorSymbol] == 7, "map holds ERROR");
+    Check(map[1] == -1, "map defaults other symbols");
+}
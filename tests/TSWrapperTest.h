@@ -0,0 +1,37 @@
+#pragma once
+
+// The harness shared by the TSWrapperTests sources. Tests register themselves
+// with TSWRAPPER_TEST and report problems with Check; TSWrapperTests.cpp runs
+// them all from main.
+
+#include "TSWrapperLib.h"
+
+#include <cstdint>
+
+extern "C" const TSLanguage* tree_sitter_json(void);
+
+/**
+ * Adds a test to the list main runs. Use through TSWRAPPER_TEST.
+ */
+class CTSTestRegistration
+{
+public:
+    CTSTestRegistration(const char* name, void (*body)());
+};
+
+#define TSWRAPPER_TEST(name)                                                     \
+    static void name();                                                          \
+    static const CTSTestRegistration name##Registration(#name, &name);           \
+    static void name()
+
+/**
+ * Record a failed check of the running test unless condition holds.
+ */
+void Check(bool condition, const char* what);
+
+bool operator==(const TSRange& left, const TSRange& right);
+
+/**
+ * An edit of single-line text, where columns equal byte offsets.
+ */
+TSInputEdit SingleLineEdit(uint32_t start_byte, uint32_t old_end_byte, uint32_t new_end_byte);
@@ -0,0 +1,76 @@
+// Regression tests for the wrapper, run against tree-sitter-json.
+//
+//     TSWrapperTests
+//
+// Each test prints its name and the checks that failed; the exit status is the
+// number of failed checks. CTSMemory is installed, with pooling, before any
+// tree-sitter object is created, so every test runs on the wrapper's own
+// allocator.
+
+#include "TSWrapperTest.h"
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace
+{
+int         g_failures = 0;
+const char *g_current  = "";
+
+std::vector<std::pair<const char *, void (*)()> >& Tests()
+{
+    static std::vector<std::pair<const char *, void (*)()> > tests;
+
+    return tests;
+}
+}
+
+CTSTestRegistration::CTSTestRegistration(const char *name, void (*body)())
+{
+    Tests().emplace_back(name, body);
+}
+
+void Check(bool condition, const char *what)
+{
+    if (!condition)
+    {
+        std::printf("FAIL %s: %s\n", g_current, what);
+        g_failures++;
+    }
+}
+
+bool operator==(const TSRange& left, const TSRange& right)
+{
+    return (left.start_byte == right.start_byte) && (left.end_byte == right.end_byte) &&
+           (left.start_point.row == right.start_point.row) && (left.start_point.column == right.start_point.column) &&
+           (left.end_point.row == right.end_point.row) && (left.end_point.column == right.end_point.column);
+}
+
+TSInputEdit SingleLineEdit(uint32_t start_byte, uint32_t old_end_byte, uint32_t new_end_byte)
+{
+    TSInputEdit retval;
+
+    retval.start_byte    = start_byte;
+    retval.old_end_byte  = old_end_byte;
+    retval.new_end_byte  = new_end_byte;
+    retval.start_point   = { 0, start_byte };
+    retval.old_end_point = { 0, old_end_byte };
+    retval.new_end_point = { 0, new_end_byte };
+    return retval;
+}
+
+int main()
+{
+    CTSMemory::Install(true);
+
+    for (const auto& test : Tests())
+    {
+        g_current = test.first;
+        std::printf("%s\n", test.first);
+        test.second();
+    }
+
+    std::printf("%d failed check(s)\n", g_failures);
+    return g_failures;
+}